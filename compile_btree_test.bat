@@ -8,10 +8,20 @@ g++ -std=c++17 -I./include ^
     src/storage/record.cpp ^
     src/storage/table.cpp ^
     src/storage/slot_helpers.cpp ^
+    src/storage/buffer_pool.cpp ^
+    src/storage/async_disk_manager.cpp ^
+    src/storage/mapped_file.cpp ^
+    src/storage/free_space_map.cpp ^
+    src/common/crc32c.cpp ^
     src/storage/btree/btree.cpp ^
     src/storage/btree/leaf.cpp ^
     src/storage/btree/internal.cpp ^
     src/storage/btree/helpers.cpp ^
+    src/storage/btree/cursor.cpp ^
+    src/storage/btree/delete.cpp ^
+    src/storage/btree/bulk_load.cpp ^
+    src/storage/btree/batch.cpp ^
+    src/storage/btree/overflow.cpp ^
     -o test_btree.exe
 
 REM Run the test
@@ -2,9 +2,20 @@
 #include <cstdint>
 
 inline constexpr uint32_t PAGE_SIZE = 8192;
+// Page buffers are aligned to this so they can be used for O_DIRECT I/O (4 KiB covers every common logical block size)
+inline constexpr uint32_t PAGE_ALIGNMENT = 4096;
 inline constexpr uint32_t INVALID_PAGE_ID = -1;
 inline constexpr uint32_t BUFFER_POOL_SIZE = 100;
 inline constexpr uint32_t MAX_FILE_PATH_LENGTH = 255;
+// Longest key the B+ tree accepts. Separators are copied into internal nodes, which still have
+// to hold three entries of this size for a split to leave a key on either side.
+inline constexpr uint16_t MAX_KEY_SIZE = 2048;
+// Values longer than this live in a chain of overflow pages, the leaf record keeps the first
+// OVERFLOW_PREFIX bytes and a pointer to the chain, so big rows don't crowd out their neighbours
+inline constexpr uint16_t MAX_INLINE_VALUE = 1024;
+inline constexpr uint16_t OVERFLOW_PREFIX = 64;
 
 
-inline constexpr uint8_t RECORD_DELETED = 1 << 0;
\ No newline at end of file
+inline constexpr uint8_t RECORD_DELETED = 1 << 0;
+// the value is OVERFLOW_PREFIX bytes followed by an OverflowRef
+inline constexpr uint8_t RECORD_OVERFLOW = 1 << 1;
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// CRC32C (Castagnoli). Uses the SSE4.2 / ARMv8 crc32 instructions when the CPU has them
+// (checked once at startup), a slicing-by-8 table otherwise.
+// crc is the value returned for the preceding bytes, so data can be checksummed in pieces.
+uint32_t crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+// true if crc32c() runs on the hardware instruction
+bool crc32c_hardware();
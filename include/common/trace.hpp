@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// Compile-time trace level. Anything above the level compiles to nothing.
+//   0 = off (default)
+//   1 = I/O events are recorded into the runtime ring buffer (when enabled)
+//   2 = events are also printed to std::clog
+// Debug builds get level 1 from CMakeLists.txt, override with -DADVANCEDB_TRACE_LEVEL=N.
+#ifndef ADVANCEDB_TRACE_LEVEL
+#define ADVANCEDB_TRACE_LEVEL 0
+#endif
+
+enum class TraceLevel : int {
+    OFF = 0,
+    EVENTS = 1,
+    VERBOSE = 2
+};
+
+inline constexpr TraceLevel TRACE_LEVEL = static_cast<TraceLevel>(ADVANCEDB_TRACE_LEVEL);
+
+inline constexpr bool trace_enabled(TraceLevel level) {
+    return static_cast<int>(level) <= static_cast<int>(TRACE_LEVEL) && level != TraceLevel::OFF;
+}
+
+enum class IoOp : uint8_t {
+    READ = 0,
+    WRITE = 1,
+    SYNC = 2
+};
+
+struct IoEvent {
+    uint64_t timestamp_ns; // steady clock
+    IoOp op;
+    uint32_t page_id;
+    uint32_t bytes;
+};
+
+// Fixed size ring of the most recent I/O events. Disabled (and empty) until enable() is called,
+// so even a tracing build only pays for it when someone is looking.
+class IoTraceBuffer {
+public:
+    void enable(size_t capacity) {
+        std::lock_guard<std::mutex> lock(latch);
+        events.assign(capacity, IoEvent{});
+        next = 0;
+        on = capacity > 0;
+    }
+
+    void disable() {
+        std::lock_guard<std::mutex> lock(latch);
+        on = false;
+        events.clear();
+        next = 0;
+    }
+
+    bool enabled() const { return on; }
+
+    void record(const IoEvent& event) {
+        std::lock_guard<std::mutex> lock(latch);
+        if (!on) return;
+        events[next % events.size()] = event;
+        next++;
+    }
+
+    // Events oldest first
+    std::vector<IoEvent> snapshot() const {
+        std::lock_guard<std::mutex> lock(latch);
+        std::vector<IoEvent> out;
+        if (!on) return out;
+        size_t count = next < events.size() ? next : events.size();
+        out.reserve(count);
+        for (uint64_t i = next - count; i < next; i++) {
+            out.push_back(events[i % events.size()]);
+        }
+        return out;
+    }
+
+    // total number of events recorded, including ones that were overwritten
+    uint64_t total() const {
+        std::lock_guard<std::mutex> lock(latch);
+        return next;
+    }
+
+private:
+    mutable std::mutex latch;
+    std::vector<IoEvent> events;
+    uint64_t next{0};
+    std::atomic<bool> on{false};
+};
+
+inline IoTraceBuffer& io_trace() {
+    static IoTraceBuffer buffer;
+    return buffer;
+}
+
+inline const char* io_op_name(IoOp op) {
+    switch (op) {
+        case IoOp::READ: return "read";
+        case IoOp::WRITE: return "write";
+        case IoOp::SYNC: return "sync";
+    }
+    return "?";
+}
+
+// Hot path hook. With ADVANCEDB_TRACE_LEVEL=0 the body is discarded at compile time.
+inline void trace_io(IoOp op, uint32_t page_id, uint32_t bytes) {
+    if constexpr (trace_enabled(TraceLevel::EVENTS)) {
+        IoTraceBuffer& buffer = io_trace();
+        if (buffer.enabled()) {
+            auto now = std::chrono::steady_clock::now().time_since_epoch();
+            uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+            buffer.record({ns, op, page_id, bytes});
+        }
+    }
+    if constexpr (trace_enabled(TraceLevel::VERBOSE)) {
+        // '\n' rather than std::endl, the trace must not flush on every page
+        std::clog << "[io] " << io_op_name(op) << " page " << page_id << " (" << bytes << " bytes)\n";
+    }
+}
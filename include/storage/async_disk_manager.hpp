@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+#include "storage/disk_manager.hpp"
+#include "storage/page.hpp"
+
+// Completion callback, ok is false if the read or write failed
+using IoCallback = std::function<void(bool ok)>;
+
+// Asynchronous page I/O on top of a DiskManager's file.
+//
+// Requests are queued by read_page_async / write_page_async and handed to the kernel
+// together by submit(), so a flusher can push hundreds of dirty pages in one syscall.
+// Callbacks run on the thread that reaps completions (poll / wait_all).
+//
+// With liburing (ADVANCEDB_HAVE_LIBURING, set by CMake when it is found) requests go
+// through an io_uring. Without it, or when the kernel refuses to set up a ring,
+// submit() performs the queued requests synchronously with pread/pwrite and completes
+// them immediately, so callers see the same API either way. Both paths go through the
+// DiskManager's extent reservation, and both apply its sync policy once per batch of writes
+// rather than once per page.
+//
+// Setting up a ring costs a few syscalls and locked memory, keep one around for the life of
+// the file instead of one per batch (BufferPoolManager holds one for its flushes).
+//
+// Not thread safe: one AsyncDiskManager per submitting thread.
+class AsyncDiskManager {
+public:
+    explicit AsyncDiskManager(DiskManager& disk_manager, unsigned queue_depth = 256);
+    ~AsyncDiskManager(); // waits for everything in flight
+
+    AsyncDiskManager(const AsyncDiskManager&) = delete;
+    AsyncDiskManager& operator=(const AsyncDiskManager&) = delete;
+
+    // The buffer must stay valid (and unmodified for writes) until the request completes.
+    // Like DiskManager, writes stamp the page checksum and reads verify it (ok = false on a mismatch).
+    void read_page_async(uint32_t page_id, uint8_t* page_data, IoCallback callback);
+    void write_page_async(uint32_t page_id, uint8_t* page_data, IoCallback callback);
+
+    // Same as above, the future becomes ready once the request completes
+    std::future<bool> read_page_async(uint32_t page_id, uint8_t* page_data);
+    std::future<bool> write_page_async(uint32_t page_id, uint8_t* page_data);
+
+    // Hand every queued request to the kernel, returns how many were submitted.
+    // Queuing past queue_depth submits on its own.
+    size_t submit();
+    // Run callbacks for completed requests without blocking, returns how many completed
+    size_t poll();
+    // Submit whatever is queued and block until nothing is in flight
+    void wait_all();
+
+    bool uses_io_uring() const { return ring != nullptr; }
+    size_t pending() const { return queued.size() + in_flight; }
+
+private:
+    struct Request {
+        bool is_write;
+        uint32_t page_id;
+        uint8_t* buffer;
+        IoCallback callback;
+        // aligned stand-in for buffer when O_DIRECT is on and buffer is not aligned
+        std::unique_ptr<Page> bounce;
+    };
+    struct Ring;
+
+    void enqueue(Request request);
+    void complete(Request& request, bool ok);
+    size_t submit_sync();
+    size_t poll_ring(bool wait); // io_uring builds only
+    void submit_ring();          // io_uring builds only
+
+    DiskManager& dm;
+    unsigned depth;
+    std::vector<Request> queued;
+    size_t in_flight{0};
+    std::unique_ptr<Ring> ring; // null when running on the synchronous fallback
+};
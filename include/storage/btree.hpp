@@ -2,7 +2,9 @@
 #include <cstdint>
 #include "storage/table_handle.hpp"
 #include "storage/page.hpp"
+#include "storage/record.hpp"
 #include <vector>
+#include <functional>
 struct Key {
     const uint8_t* data;
     uint16_t size;
@@ -12,7 +14,8 @@ using Value = Key;
 
 struct SplitLeafResult {
     uint32_t new_page;
-    Key seperator_key;
+    Key seperator_key; // points into key_buf, valid as long as the result is
+    std::vector<uint8_t> key_buf;
 };
 
 using SplitInternalResult = SplitLeafResult;
@@ -20,6 +23,78 @@ using SplitInternalResult = SplitLeafResult;
 // Main B+ tree operations
 bool btree_search(TableHandle& th, const Key& key, Value& value);
 bool btree_insert(TableHandle& th, const Key& key, const Value& value);
+// Removes key, false if it isn't there. Nodes that drop below a quarter full borrow from or
+// merge with a sibling, the root collapses when it is left with one child, and emptied pages
+// go back to the allocator.
+bool btree_delete(TableHandle& th, const Key& key);
+
+struct BatchEntry {
+    Key key;
+    Value value;
+};
+
+// Inserts a batch in key order: one descent per target leaf, then every key that belongs to
+// that leaf goes in while it stays pinned. A full leaf is split through btree_insert and the
+// rest of the batch descends again. Keys already in the tree (and repeats within the batch)
+// are skipped, returns how many were inserted.
+size_t btree_insert_batch(TableHandle& th, const std::vector<BatchEntry>& batch);
+
+struct MultiGetResult {
+    bool found{false};
+    std::vector<uint8_t> value; // copied out, the leaf is unpinned by the time the call returns
+};
+
+// Looks up many keys at once, results in input order. Keys are probed in sorted order along a
+// shared root-to-leaf path: the next key only climbs as far as the first node whose key range
+// covers it, so keys in the same leaf cost one search of that leaf and no extra page access.
+std::vector<MultiGetResult> btree_multi_get(TableHandle& th, const std::vector<Key>& keys);
+
+// Pulls the next pair for btree_bulk_load: fills key / value and returns true, false at the end.
+// Keys must be strictly ascending, the bytes only have to stay valid until the next call.
+using BulkLoadSource = std::function<bool(Key& key, Value& value)>;
+
+// Builds the tree bottom-up from sorted input in one pass: leaves are packed to fill_factor,
+// internal levels grow as the leaves complete, and pages go straight to disk in allocation
+// order as batched vectored writes (not through the pool). Only loads into an empty tree.
+// Values past MAX_INLINE_VALUE get their overflow chains written alongside the leaves.
+// Returns false, leaving the tree empty, if the tree isn't empty, the input is out of order
+// or a key is longer than MAX_KEY_SIZE. Call flush_table afterwards to make the load durable.
+bool btree_bulk_load(TableHandle& th, const BulkLoadSource& next, double fill_factor = 0.9);
+
+// Scan over the leaves in key order, either way. Leaves are chained through next / prev links,
+// so after the first seek the cursor never goes back to the root. The current leaf stays
+// pinned while the cursor is on it.
+class BTreeCursor {
+public:
+    explicit BTreeCursor(TableHandle& th) : th(&th) {}
+
+    // Position on the first key >= key, false if there is none
+    bool seek(const Key& key);
+    bool seek_first();
+    // Position on the last key <= key, false if there is none
+    bool seek_for_prev(const Key& key);
+    bool seek_last();
+    // Move to the following / preceding key, false (and invalid) past either end
+    bool next();
+    bool prev();
+    bool valid() const { return leaf.valid(); }
+
+    // Only valid until the cursor moves. The key is put together (page prefix and the rest)
+    // in a buffer of the cursor, the value points into the leaf unless it is kept in overflow
+    // pages and has to be read into a buffer as well.
+    Key key();
+    Value value();
+
+private:
+    bool settle();
+    bool settle_back();
+
+    TableHandle* th;
+    PageGuard leaf;
+    uint16_t index{0};
+    std::vector<uint8_t> key_buf;
+    std::vector<uint8_t> value_buf;
+};
 
 #pragma pack(push, 1)
 struct InternalEntry {
@@ -29,18 +104,66 @@ struct InternalEntry {
 };
 #pragma pack(pop)
 
+static_assert(3 * (sizeof(InternalEntry) + MAX_KEY_SIZE + sizeof(uint16_t)) <= PAGE_DATA_END - sizeof(PageHeader),
+              "An internal page must hold three entries of MAX_KEY_SIZE");
+static_assert(MAX_INLINE_VALUE >= OVERFLOW_PREFIX + sizeof(OverflowRef), "Overflow stub must be shorter than an inline value");
+
 
 //helpers 
 uint16_t write_raw_record(Page& page, const uint8_t* raw, uint16_t size);
+uint16_t cell_size(Page& page, uint16_t slot_index);
+void truncate_page(Page& page, uint16_t keep);
+uint16_t live_bytes(Page& page);
+// true if a cell of size bytes fits, compacting the page first if its dead space is needed
+// (internal pages, page_insert does this for leaves)
+bool make_room(Page& page, uint16_t size);
+// Where a full page splits so that a cell of size bytes still to go in at index at fits: the
+// first cell of the right page (internal pages: the separator that moves up)
+uint16_t split_point(Page& page, uint16_t at, uint16_t size);
+// Shortest separator between neighbouring leaf keys, last < separator <= first: first cut
+// one byte past where it stops matching last
+void shortest_separator(const Key& last, const Key& first, std::vector<uint8_t>& separator);
+// next leaf in key order, 0 on the last one (kept in reserved[0..3], internal pages keep
+// their leftmost child there)
+uint32_t leaf_next(Page& page);
+void set_leaf_next(Page& page, uint32_t page_id);
+// previous leaf, 0 on the first one (kept in root_page, only the meta page uses it)
+uint32_t leaf_prev(Page& page);
+void set_leaf_prev(Page& page, uint32_t page_id);
+
+// overflow
+// bytes of a value one overflow page holds
+inline constexpr uint32_t OVERFLOW_CHUNK = PAGE_DATA_END - sizeof(PageHeader);
+inline bool needs_overflow(const Value& value) { return value.size > MAX_INLINE_VALUE; }
+// Pages needed for the part of a value_size byte value past the inline prefix
+uint32_t overflow_page_count(uint32_t value_size);
+// Fill page as chunk of value's chain, linked to next (0 on the last page)
+void init_overflow_page(Page& page, uint32_t page_id, uint32_t next, const Value& value, uint32_t chunk);
+// Leaf value for an overflowed value: its prefix and the ref to first_page, built in buf
+Value overflow_stub(const Value& value, uint32_t first_page, std::vector<uint8_t>& buf);
+// Write value's chain through the pool and return the stub the leaf stores
+Value spill_value(TableHandle& th, const Value& value, std::vector<uint8_t>& buf);
+// Value of a leaf record: points into the page, or into buf when it has to be read from its chain
+Value record_value(TableHandle& th, Page& leaf, uint16_t index, std::vector<uint8_t>& buf);
+// Give back the chain of a leaf record, if it has one
+void free_overflow(TableHandle& th, Page& leaf, uint16_t index);
+// Give back the chain behind a stub spill_value returned, for a record that never got stored
+void free_overflow(TableHandle& th, const Value& stub);
 
 // leaf 
-uint32_t find_leaf_page(TableHandle& th, const Key& key, Page& out_page);
-bool btree_insert_leaf_no_split(TableHandle& th, uint32_t page_id, Page& page, const Key& key, const Value& value);
-SplitLeafResult split_leaf_page(TableHandle& th, Page& page);
+PageGuard find_leaf_page(TableHandle& th, const Key& key);
+// path: internal page ids from the root down to the leaf's parent
+PageGuard find_leaf_page(TableHandle& th, const Key& key, std::vector<uint32_t>& path);
+bool btree_insert_leaf_no_split(PageGuard& leaf, const Key& key, const Value& value, uint8_t flags = 0);
+// key / size: the record the split makes room for (size without a prefix), see split_point
+SplitLeafResult split_leaf_page(TableHandle& th, Page& page, const Key& key, uint16_t size);
 
 // internal
+const uint8_t* internal_key(Page& page, uint16_t slot_index, uint16_t& key_len);
+BSearchResult search_internal(Page& page, const uint8_t* key, uint16_t key_len);
 uint32_t internal_find_child(Page& page, const Key& key);
+uint16_t write_internal_entry(Page& page, const Key& key, uint32_t child);
 bool insert_internal_no_split(Page& page, const Key& key, uint32_t child);
-SplitInternalResult split_internal_page(TableHandle& th, Page& page);
+SplitInternalResult split_internal_page(TableHandle& th, Page& page, uint16_t at, uint16_t size);
 void create_new_root(TableHandle& th, uint32_t left, const Key& key, uint32_t right);
-void insert_into_parent(TableHandle& th, uint32_t left, const Key& key, uint32_t right);
\ No newline at end of file
+void insert_into_parent(TableHandle& th, std::vector<uint32_t>& path, uint32_t left, const Key& key, uint32_t right);
\ No newline at end of file
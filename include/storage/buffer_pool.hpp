@@ -0,0 +1,158 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "common/constants.hpp"
+#include "storage/page.hpp"
+
+class DiskManager;
+class AsyncDiskManager;
+class PageGuard;
+
+using frame_id_t = uint32_t;
+
+// Eviction policy used by the buffer pool. Only unpinned frames are handed to
+// the replacer, so anything it returns from victim() is safe to reuse.
+class Replacer {
+public:
+    virtual ~Replacer() = default;
+
+    // frame became evictable (pin count dropped to 0)
+    virtual void unpin(frame_id_t frame_id) = 0;
+    // frame is in use again and must not be evicted
+    virtual void pin(frame_id_t frame_id) = 0;
+    // pick a frame to evict, returns false if nothing is evictable
+    virtual bool victim(frame_id_t& frame_id) = 0;
+    virtual size_t size() const = 0;
+};
+
+// Least recently unpinned frame is evicted first
+class LRUReplacer : public Replacer {
+public:
+    explicit LRUReplacer(size_t num_frames);
+
+    void unpin(frame_id_t frame_id) override;
+    void pin(frame_id_t frame_id) override;
+    bool victim(frame_id_t& frame_id) override;
+    size_t size() const override;
+
+private:
+    std::list<frame_id_t> lru_list; // front = most recent
+    std::vector<std::list<frame_id_t>::iterator> positions;
+    std::vector<bool> in_list;
+};
+
+// Second-chance clock, cheaper bookkeeping than LRU on every unpin
+class ClockReplacer : public Replacer {
+public:
+    explicit ClockReplacer(size_t num_frames);
+
+    void unpin(frame_id_t frame_id) override;
+    void pin(frame_id_t frame_id) override;
+    bool victim(frame_id_t& frame_id) override;
+    size_t size() const override;
+
+private:
+    std::vector<bool> evictable;
+    std::vector<bool> ref_bit;
+    size_t hand{0};
+    size_t count{0};
+};
+
+struct Frame {
+    Page* page{nullptr}; // points into BufferPoolManager::page_memory
+    uint32_t page_id{INVALID_PAGE_ID};
+    uint32_t pin_count{0};
+    bool is_dirty{false};
+};
+
+class BufferPoolManager {
+public:
+    BufferPoolManager(size_t pool_size, DiskManager* disk_manager,
+                      std::unique_ptr<Replacer> policy = nullptr);
+    ~BufferPoolManager();
+
+    BufferPoolManager(const BufferPoolManager&) = delete;
+    BufferPoolManager& operator=(const BufferPoolManager&) = delete;
+
+    // Pin page_id in the pool, reading it from disk on a miss.
+    // Throws if every frame is pinned.
+    Page* fetch_page(uint32_t page_id);
+
+    // Pin a frame for a freshly allocated page_id without reading it from disk.
+    // The frame is zeroed and marked dirty. Throws if page_id is cached and still pinned.
+    Page* new_page(uint32_t page_id);
+
+    // Drop one pin, is_dirty is sticky until the page is written back
+    bool unpin_page(uint32_t page_id, bool is_dirty);
+
+    // Same as above, but the pin is released when the guard goes out of scope
+    PageGuard fetch_page_guard(uint32_t page_id);
+    PageGuard new_page_guard(uint32_t page_id);
+
+    bool flush_page(uint32_t page_id);
+    // Forget page_id without writing it back, for pages that are about to be written to disk
+    // directly. False if the page is pinned.
+    bool discard_page(uint32_t page_id);
+    void flush_all_pages();
+
+    // Write back all dirty pages and forget every cached page.
+    // Used when the underlying file is swapped out (see open_table). Throws, changing nothing,
+    // if a page is pinned; a failed write leaves every page cached.
+    void reset();
+
+    size_t pool_size() const { return frames.size(); }
+    uint64_t hits() const { return hit_count; }
+    uint64_t misses() const { return miss_count; }
+
+private:
+    bool get_free_frame(frame_id_t& frame_id);
+    void flush_frame(Frame& frame);
+
+    // Page buffers live in one contiguous, PAGE_ALIGNMENT aligned block separate from the
+    // frame bookkeeping, so they can go to O_DIRECT I/O and Frame carries no alignment padding
+    std::vector<Page> page_memory;
+    std::vector<Frame> frames;
+    std::unordered_map<uint32_t, frame_id_t> page_table;
+    std::list<frame_id_t> free_list;
+    std::unique_ptr<Replacer> replacer;
+    DiskManager* disk_manager;
+    // flush_all_pages batches its writes through this, set up on the first flush and kept so
+    // an io_uring is not created and torn down on every flush
+    std::unique_ptr<AsyncDiskManager> async_io;
+    std::mutex latch;
+
+    uint64_t hit_count{0};
+    uint64_t miss_count{0};
+};
+
+// Pins a page for the lifetime of the guard and unpins it on destruction
+class PageGuard {
+public:
+    PageGuard() = default;
+    PageGuard(BufferPoolManager* bpm, uint32_t page_id, Page* page)
+        : bpm(bpm), pid(page_id), frame_page(page) {}
+    ~PageGuard() { release(); }
+
+    PageGuard(PageGuard&& other) noexcept;
+    PageGuard& operator=(PageGuard&& other) noexcept;
+
+    PageGuard(const PageGuard&) = delete;
+    PageGuard& operator=(const PageGuard&) = delete;
+
+    Page& page() { return *frame_page; }
+    uint32_t page_id() const { return pid; }
+    bool valid() const { return frame_page != nullptr; }
+    void mark_dirty() { dirty = true; }
+    void release();
+
+private:
+    BufferPoolManager* bpm{nullptr};
+    uint32_t pid{INVALID_PAGE_ID};
+    Page* frame_page{nullptr};
+    bool dirty{false};
+};
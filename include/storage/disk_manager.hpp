@@ -1,10 +1,41 @@
 #pragma once
 #include <string>
 #include <cstdint>
+#include <chrono>
+#include <vector>
+
+// When DiskManager forces written pages to stable storage.
+// flush() is always a full barrier regardless of the policy.
+enum class SyncPolicy : uint8_t {
+    EVERY_WRITE = 0,  // fsync after every write_page (slowest, old behaviour)
+    GROUP = 1,        // caller decides, one flush() per transaction / batch of writes
+    PERIODIC = 2,     // write_page syncs at most once per sync_interval_ms, see sync_if_due()
+    NONE = 3          // never sync implicitly, only on an explicit flush()
+};
+
+struct DiskManagerOptions {
+    SyncPolicy sync_policy{SyncPolicy::GROUP};
+    uint32_t sync_interval_ms{1000}; // only used by SyncPolicy::PERIODIC
+    // Bypass the OS page cache (O_DIRECT on Linux, F_NOCACHE on macOS) so the buffer pool
+    // holds the only cached copy. Ignored where unsupported, see DiskManager::direct_io().
+    bool direct_io{false};
+    // The file grows in extents of this many pages (preallocated with fallocate where
+    // available) instead of one page per write. 1 grows page by page.
+    uint32_t extent_pages{64};
+    // Open the file O_RDONLY: no write permission needed, the constructor throws instead of
+    // creating a missing file, and every write throws
+    bool read_only{false};
+};
+
+// One page of a vectored read_pages / write_pages batch
+struct PageBuffer {
+    uint32_t page_id;
+    uint8_t* data;
+};
 
 class DiskManager {
 public:
-    DiskManager(const std::string& file_path);
+    DiskManager(const std::string& file_path, const DiskManagerOptions& options = {});
     ~DiskManager();
 
     DiskManager(DiskManager&& other) noexcept;
@@ -13,10 +44,58 @@ public:
     DiskManager(const DiskManager&) = delete;
     DiskManager& operator=(const DiskManager&) = delete;
 
-    void read_page(int page_id, uint8_t* page_data);
-    void write_page(int page_id, const void* page_data); // void as pointer can be anything for now
+    // page_id is unsigned and offsets are 64-bit, so tables can grow past 2 GB.
+    // Both use positional I/O (pread/pwrite) and never move the shared file offset.
+    // read_page throws if the page checksum does not match (torn write / corruption),
+    // write_page stamps the checksum into the trailer of page_data before writing it.
+    void read_page(uint32_t page_id, uint8_t* page_data);
+    void write_page(uint32_t page_id, uint8_t* page_data);
+    // Batched versions: adjacent page ids are coalesced into one preadv / pwritev per run,
+    // in any order the batch comes in. write_pages applies the sync policy once per batch.
+    void read_pages(const std::vector<PageBuffer>& pages);
+    void write_pages(const std::vector<PageBuffer>& pages);
+
+    // Sync barrier: everything written before it is durable once it returns
     void flush();
+    // SyncPolicy::PERIODIC only checks the interval when a write comes in, there is no timer.
+    // Pages written just before the writes stop stay unsynced until the next write or flush(),
+    // so an idle loop or timer should call this: it syncs when writes are pending and
+    // sync_interval_ms has passed since the last sync, and returns true if it did.
+    bool sync_if_due();
+
+    const DiskManagerOptions& options() const { return opts; }
+    void set_sync_policy(SyncPolicy policy, uint32_t interval_ms = 1000);
+    uint64_t sync_count() const { return syncs; }
+
+    // For writes issued on the descriptor outside write_page (AsyncDiskManager).
+    // prepare_write stamps the checksum and reserves the page's extent before the write goes
+    // out; write_completed marks the file unsynced and applies the sync policy, once per batch
+    // like write_pages.
+    void prepare_write(uint32_t page_id, uint8_t* page_data);
+    void write_completed();
+    int native_handle() const { return file_descriptor; }
+    // true if the file really was opened for direct I/O (the filesystem may refuse it)
+    bool direct_io() const { return direct; }
+    // Size of the file including preallocated, not yet written extents
+    uint64_t allocated_bytes() const { return allocated_size; }
 
 private: 
+    void sync_after_write();
+    void check_writable() const;
+    void grow_file(uint64_t offset);
+    void write_one(uint32_t page_id, uint8_t* page_data);
+    size_t run_length(const std::vector<PageBuffer>& sorted, size_t first) const;
+    void read_run(const PageBuffer* run, size_t count);
+    void write_run(const PageBuffer* run, size_t count);
+
+    // iovec count limit for one vectored call (IOV_MAX is 1024 on Linux)
+    static constexpr size_t MAX_IO_RUN = 1024;
+
     int file_descriptor{-1};
+    DiskManagerOptions opts;
+    bool direct{false};
+    uint64_t allocated_size{0};
+    bool unsynced_writes{false};
+    uint64_t syncs{0};
+    std::chrono::steady_clock::time_point last_sync{std::chrono::steady_clock::now()};
 };
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "common/constants.hpp"
+#include "storage/page.hpp"
+
+class BufferPoolManager;
+
+// Two level page allocation map for a table.
+//
+// Level 0: bitmap pages, bit set = page in use. Bitmap k covers pages
+// [k * PAGES_PER_BITMAP, (k + 1) * PAGES_PER_BITMAP) and lives in the first page it covers,
+// except bitmap 0 which is page 1 (page 0 is the meta page). New bitmaps are created as the
+// table outgrows the existing ones, so the page id space (32 TiB at 8 KiB pages) is the limit.
+//
+// Level 1: a "bitmap is full" bit per bitmap page, kept in the meta page body together with
+// the bitmap count. Allocation finds a bitmap with room by scanning summary words, then a free
+// page inside it 64 pages per step, both from next-free hints, so it is O(1) amortized.
+//
+// Index pages are placed by level: each PageLevel owns an extent, a run of EXTENT_PAGES free
+// pages (one bitmap word) it allocates from in order, and a split asks for the page right after
+// the page being split first. Leaves that follow each other in key order then mostly follow each
+// other in the file too, so scans read sequentially. Extents are only reserved in memory, plain
+// allocate() leaves them alone while they are active.
+//
+// Everything is held in memory (bitmaps past the first load on first use) and never touches the disk on
+// allocate / release: write_back() copies changed bitmaps and the summary into their pages
+// in the buffer pool, flush_table and TableHandle teardown call it.
+class FreeSpaceMap {
+public:
+    static constexpr uint32_t BITMAP_WORDS = (PAGE_DATA_END - sizeof(PageHeader)) / sizeof(uint64_t);
+    static constexpr uint32_t PAGES_PER_BITMAP = BITMAP_WORDS * 64;
+    static constexpr uint32_t EXTENT_PAGES = 64;
+
+    // Read the summary and the first bitmap, later bitmaps are fetched through bpm when first needed
+    void load(BufferPoolManager& bpm);
+    // Copy changed bitmaps and the summary into their pages (marked dirty, written with the
+    // other dirty pages). Nothing happens if nothing changed.
+    void write_back(BufferPoolManager& bpm);
+    void clear();
+
+    bool loaded() const { return pool != nullptr; }
+
+    // Lowest free page at or after the hints, INVALID_PAGE_ID once the page id space is used up
+    uint32_t allocate();
+    // Page for a new node of the given level: near + 1 if that is free, else the next page of the
+    // level's extent, else a fresh extent. Falls back to allocate() when no whole extent is free.
+    uint32_t allocate(PageLevel level, uint32_t near = INVALID_PAGE_ID);
+    // Queued, not applied: frees are batched into the bitmaps on the next allocation, lookup or
+    // write_back, so a mass delete costs a vector push per page and one pass per bitmap
+    void release(uint32_t page_id);
+    size_t pending_frees() const { return pending.size(); }
+    bool is_allocated(uint32_t page_id);
+
+    uint32_t bitmap_count() const { return static_cast<uint32_t>(bitmaps.size()); }
+    uint32_t capacity() const { return bitmap_count() * PAGES_PER_BITMAP; }
+    // loads every bitmap
+    uint32_t allocated_count();
+
+private:
+    struct Bitmap {
+        std::vector<uint64_t> words; // empty until loaded
+        size_t hint{0};              // no free bit in any word before this one
+        bool dirty{false};
+    };
+
+    struct Extent {
+        uint32_t next{INVALID_PAGE_ID}; // pages before next were handed out or skipped
+        uint32_t end{INVALID_PAGE_ID};
+    };
+
+    Bitmap& bitmap(size_t k);
+    uint32_t allocate_in(size_t k);
+    void add_bitmap();
+    void set_full(size_t k, bool is_full);
+    bool take(uint32_t page_id, size_t level);
+    bool in_extent(uint32_t first, uint32_t last, size_t except) const;
+    uint32_t reserve_extent();
+    void retire_extent(Extent& e);
+    void apply_pending();
+    static uint32_t bitmap_page_id(size_t k);
+
+    BufferPoolManager* pool{nullptr};
+    std::vector<Bitmap> bitmaps;
+    std::vector<uint32_t> pending; // freed pages not yet cleared in their bitmaps
+    std::vector<uint64_t> full;  // summary, bit k set = bitmap k has no free page
+    size_t hint{0};              // no bitmap before this one has a free page
+    bool summary_dirty{false};
+    Extent extents[3];           // indexed by PageLevel
+    size_t extent_hint{0};       // no wholly free word before this one (counted across bitmaps)
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include "storage/page.hpp"
+
+// Read-only memory mapping of a table file. Pages are resolved to pointers straight into
+// the mapping, so reads copy nothing and the OS decides what stays resident.
+// The mapping covers the file as it was when open() was called.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& file_path);
+    void close();
+
+    bool is_open() const { return base != nullptr; }
+    uint32_t page_count() const { return static_cast<uint32_t>(length / PAGE_SIZE); }
+
+    // nullptr if the page lies past the end of the mapping.
+    // The memory is mapped read-only, writing through the pointer faults.
+    const Page* page(uint32_t page_id) const;
+
+    // Checks the page's checksum the first time it is asked for and remembers a match,
+    // the pool path gets the same check from DiskManager::read_page on every miss.
+    bool verify(uint32_t page_id) const;
+
+private:
+    uint8_t* base{nullptr};
+    uint64_t length{0};
+    mutable std::unique_ptr<std::atomic<bool>[]> verified; // one flag per page
+#ifdef _WIN32
+    void* mapping{nullptr}; // HANDLE of the file mapping object
+#endif
+};
@@ -7,7 +7,8 @@ enum class PageType : uint16_t {
     META = 1,
     INDEX = 2,
     DATA = 3,
-    FREE = 4
+    FREE = 4,
+    OVERFLOW = 5 // part of a large value, next page of the chain in reserved
 };
 
 enum class PageLevel : uint16_t {
@@ -24,23 +25,36 @@ struct PageHeader {
     PageLevel page_level;
 
     // might need to take a look at struct again
-    uint32_t root_page;
+    uint32_t root_page; // meta page: the tree root, leaves: the previous leaf (leaf_prev)
     uint8_t reserved[4];
-    uint16_t flags;
+    uint16_t prefix_size; // leaves: length of the key prefix every record shares, stored after the header
     uint16_t cell_count; 
     uint16_t free_start;
     uint16_t free_end;
 
-    uint32_t parent_page_id;
+    uint32_t parent_page_id; // unused, the B+ tree tracks the descent path instead
     uint32_t lsn; 
 };
 #pragma pack(pop)
 
 
-struct Page {
+// Over-aligned so any Page (stack, pool frame, vector) can be handed straight to O_DIRECT I/O
+struct alignas(PAGE_ALIGNMENT) Page {
     uint8_t data[PAGE_SIZE];
 };
 
+static_assert(sizeof(Page) == PAGE_SIZE, "Page must not be padded");
+
+// The last bytes of every page hold a CRC32C of everything before them. DiskManager stamps it
+// on write and verifies it on read, so torn or corrupt pages are caught before they are used.
+#pragma pack(push, 1)
+struct PageTrailer {
+    uint32_t checksum;
+};
+#pragma pack(pop)
+
+// End of the usable area, slots grow down from here
+inline constexpr uint16_t PAGE_DATA_END = PAGE_SIZE - sizeof(PageTrailer);
 
 static_assert(sizeof(PageHeader) ==  32, "PageHeader size must be 32 bytes");
 // get header of a page 
@@ -49,6 +63,12 @@ inline PageHeader* get_header(Page& page);
 // Page functionalities
 void init_page(Page& page, uint32_t page_id, PageType page_type, PageLevel page_level);
 
+// checksum functionalities (raw buffers, DiskManager works on those)
+uint32_t page_checksum(const uint8_t* page_data);
+void stamp_page_checksum(uint8_t* page_data);
+// Never written pages (all zeroes) pass as well
+bool verify_page_checksum(const uint8_t* page_data);
+
 // slot functionalities
 uint16_t* slot_ptr(Page& page, uint16_t index);
 void insert_slot(Page& page, uint16_t index, uint16_t record_offset);
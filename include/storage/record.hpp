@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <vector>
 
 struct Page;
 
@@ -9,6 +10,12 @@ struct RecordHeader {
     uint16_t key_size;
     uint16_t value_size;
 };
+
+// End of an overflowed value: the chain holds the bytes after the inline prefix
+struct OverflowRef {
+    uint32_t first_page;
+    uint32_t length; // of the whole value, prefix included
+};
 #pragma pack(pop)
 
 struct BSearchResult {
@@ -20,10 +27,28 @@ inline uint16_t record_size(uint16_t key_size, uint16_t value_size) {
     return sizeof(RecordHeader) + key_size + value_size;
 }
 
-uint16_t write_record(Page& page, const uint8_t* key, uint16_t key_len, const uint8_t* value, uint16_t value_len);
-const uint8_t* slot_key(Page& page, uint16_t slot_index, uint16_t& key_len);
+// Leaf pages keep the key prefix all their records share once, right after the header
+// (PageHeader::prefix_size bytes). A record's key_size is the length of the rest of its key.
+const uint8_t* page_prefix(Page& page, uint16_t& prefix_len);
+// Empty a leaf's body and start it over with prefix as the shared key prefix
+void clear_leaf(Page& page, const uint8_t* prefix, uint16_t prefix_len);
+// Rewrite leaf records [from, to) of src into dst, emptied first, under the longest prefix
+// their keys share. dst may be src, which compacts it.
+void move_records(Page& src, uint16_t from, uint16_t to, Page& dst);
+// Bytes the leaf's cells, slots and prefix (live of them now) would take with this record added
+uint32_t leaf_bytes_with(Page& page, uint32_t live, const uint8_t* key, uint16_t key_len, uint16_t value_len);
+
+// key is the full key, it must start with the page prefix
+uint16_t write_record(Page& page, const uint8_t* key, uint16_t key_len, const uint8_t* value, uint16_t value_len, uint8_t flags = 0);
+// The full key of a record, prefix included
+void slot_key(Page& page, uint16_t slot_index, std::vector<uint8_t>& key);
+// The stored part of a record's key, after the page prefix
+const uint8_t* slot_suffix(Page& page, uint16_t slot_index, uint16_t& suffix_len);
 const uint8_t* slot_value(Page& page, uint16_t slot_index, uint16_t& value_len);
 int compare_keys(const uint8_t* first, uint16_t first_size, const uint8_t* second, uint16_t second_size);
 BSearchResult search_record(Page& page, const uint8_t* key, uint16_t key_len);
 bool can_insert(Page& page, uint16_t record_size);
-bool page_insert(Page& page, const uint8_t* key, uint16_t key_size, const uint8_t* value, uint16_t value_size);
\ No newline at end of file
+// The prefix shrinks to what key still shares with it, and the page is compacted when the free
+// gap is too small. False if the key is there already or the record doesn't fit.
+bool page_insert(Page& page, const uint8_t* key, uint16_t key_size, const uint8_t* value, uint16_t value_size, uint8_t flags = 0);
+bool page_delete(Page& page, const uint8_t* key, uint16_t key_len);
\ No newline at end of file
@@ -1,27 +1,79 @@
 #pragma once
 #include <string>
 #include "storage/disk_manager.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/mapped_file.hpp"
+#include "storage/free_space_map.hpp"
 #include <cstdint>
+#include <vector>
+
+enum class TableOpenMode : uint8_t {
+    READ_WRITE = 0,
+    // Read-only, pages are served straight from a memory mapping of the file
+    // (no buffer pool copies). Inserts fail and page allocation throws.
+    MMAP_READ_ONLY = 1
+};
+
+// options with the file access mode opens need: MMAP_READ_ONLY never writes the file
+inline DiskManagerOptions options_for(TableOpenMode mode, DiskManagerOptions options) {
+    options.read_only = mode == TableOpenMode::MMAP_READ_ONLY;
+    return options;
+}
 
 struct TableHandle {
     std::string table_name;
     std::string file_path;
 
     DiskManager dm;
+    // all B+ tree page accesses go through the pool, dm is only touched on a miss / write-back
+    // declared after dm so it is destroyed (and flushed) first
+    BufferPoolManager bpm{BUFFER_POOL_SIZE, &dm};
+
+    // only open in TableOpenMode::MMAP_READ_ONLY
+    MappedFile mapped;
+
+    // page allocation bitmap, loaded by open_table and written back lazily
+    FreeSpaceMap fsm;
 
     uint32_t root_page;
 
+    // btree_search reads values kept in overflow pages into this, valid until the next search
+    std::vector<uint8_t> value_buf;
+
     TableHandle() = default;
 
-    explicit TableHandle(const std::string& name)
+    explicit TableHandle(const std::string& name, const DiskManagerOptions& options = {})
         : table_name(name),
           file_path("data/" + name + ".db"),
-          dm(file_path),
+          dm(file_path, options),
           root_page(0)
     {}
+
+    // For a handle that is opened with mode. MMAP_READ_ONLY opens the file read-only and throws
+    // if it does not exist instead of creating it.
+    TableHandle(const std::string& name, TableOpenMode mode, const DiskManagerOptions& options = {})
+        : TableHandle(name, options_for(mode, options))
+    {}
+
+    ~TableHandle() {
+        // the bitmap has to reach the pool before the pool flushes itself
+        try {
+            fsm.write_back(bpm);
+        }
+        catch (const std::exception&) {
+        }
+    }
+
+    bool read_only() const { return mapped.is_open(); }
 };
 
-bool open_table(const std::string &name, TableHandle &th);
+bool open_table(const std::string &name, TableHandle &th, TableOpenMode mode = TableOpenMode::READ_WRITE);
 bool create_table(const std::string &name);
+void flush_table(TableHandle &th);
 uint32_t allocate_page(TableHandle &th);
+// Page for a B+ tree node: taken from the level's extent, preferring near + 1 (see FreeSpaceMap)
+uint32_t allocate_page(TableHandle &th, PageLevel level, uint32_t near = INVALID_PAGE_ID);
 void free_page(TableHandle &th, uint32_t page_id);
+// Page for reading: points into the mapping in MMAP_READ_ONLY mode, otherwise pinned in the pool.
+// Either way a page whose checksum does not match throws.
+PageGuard fetch_read_page(TableHandle &th, uint32_t page_id);
@@ -0,0 +1,230 @@
+#include "common/crc32c.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CRC32C_HW_X86 1
+#define CRC32C_HW_TARGET __attribute__((target("sse4.2")))
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_HW_ARM 1
+#define CRC32C_HW_TARGET
+#endif
+
+namespace {
+
+constexpr uint32_t POLY = 0x82F63B78; // Castagnoli, bit reflected
+
+// ---------------- software: slicing-by-8 ----------------
+
+struct SoftwareTables {
+    uint32_t t[8][256];
+
+    SoftwareTables() {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t crc = n;
+            for (int k = 0; k < 8; k++) {
+                crc = (crc & 1) ? (crc >> 1) ^ POLY : crc >> 1;
+            }
+            t[0][n] = crc;
+        }
+        for (uint32_t n = 0; n < 256; n++) {
+            for (int k = 1; k < 8; k++) {
+                t[k][n] = (t[k - 1][n] >> 8) ^ t[0][t[k - 1][n] & 0xff];
+            }
+        }
+    }
+};
+
+const SoftwareTables& software_tables() {
+    static const SoftwareTables tables;
+    return tables;
+}
+
+uint32_t crc32c_sw(const uint8_t* p, size_t n, uint32_t crc) {
+    const auto& t = software_tables().t;
+    crc = ~crc;
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (n >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        word ^= crc;
+        crc = t[7][word & 0xff] ^ t[6][(word >> 8) & 0xff] ^
+              t[5][(word >> 16) & 0xff] ^ t[4][(word >> 24) & 0xff] ^
+              t[3][(word >> 32) & 0xff] ^ t[2][(word >> 40) & 0xff] ^
+              t[1][(word >> 48) & 0xff] ^ t[0][word >> 56];
+        p += 8;
+        n -= 8;
+    }
+#endif
+    while (n--) {
+        crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+#ifdef CRC32C_HW_TARGET
+
+// ---------------- hardware ----------------
+//
+// The crc32 instruction has a 3 cycle latency but issues every cycle, so three independent
+// streams run side by side and are stitched together with a "shift by BLOCK zero bytes"
+// operator (the approach from Mark Adler's crc32c.c).
+
+constexpr size_t BLOCK = 512; // bytes per stream per round, an 8 KiB page is 5 rounds plus a short tail
+
+// GF(2) 32x32 matrix times vector
+uint32_t gf2_matrix_times(const uint32_t* mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+void gf2_matrix_square(uint32_t* square, const uint32_t* mat) {
+    for (int n = 0; n < 32; n++) {
+        square[n] = gf2_matrix_times(mat, mat[n]);
+    }
+}
+
+// Tables applying `len` zero bytes (len a power of two) to a crc state in four lookups
+struct ShiftTables {
+    uint32_t t[4][256];
+
+    explicit ShiftTables(size_t len) {
+        uint32_t even[32], odd[32];
+
+        odd[0] = POLY; // operator for one zero bit
+        uint32_t row = 1;
+        for (int n = 1; n < 32; n++) {
+            odd[n] = row;
+            row <<= 1;
+        }
+        gf2_matrix_square(even, odd); // two zero bits
+        gf2_matrix_square(odd, even); // four zero bits
+
+        // keep squaring until the operator covers len bytes
+        const uint32_t* op = odd;
+        while (true) {
+            gf2_matrix_square(even, odd);
+            len >>= 1;
+            if (len == 0) {
+                op = even;
+                break;
+            }
+            gf2_matrix_square(odd, even);
+            len >>= 1;
+            if (len == 0) {
+                op = odd;
+                break;
+            }
+        }
+
+        for (uint32_t n = 0; n < 256; n++) {
+            t[0][n] = gf2_matrix_times(op, n);
+            t[1][n] = gf2_matrix_times(op, n << 8);
+            t[2][n] = gf2_matrix_times(op, n << 16);
+            t[3][n] = gf2_matrix_times(op, n << 24);
+        }
+    }
+
+    uint32_t shift(uint32_t crc) const {
+        return t[0][crc & 0xff] ^ t[1][(crc >> 8) & 0xff] ^ t[2][(crc >> 16) & 0xff] ^ t[3][crc >> 24];
+    }
+};
+
+const ShiftTables& block_shift() {
+    static const ShiftTables tables(BLOCK);
+    return tables;
+}
+
+#ifdef CRC32C_HW_X86
+CRC32C_HW_TARGET inline uint32_t hw_u64(uint32_t crc, uint64_t v) {
+    return static_cast<uint32_t>(_mm_crc32_u64(crc, v));
+}
+CRC32C_HW_TARGET inline uint32_t hw_u8(uint32_t crc, uint8_t v) {
+    return _mm_crc32_u8(crc, v);
+}
+#else
+inline uint32_t hw_u64(uint32_t crc, uint64_t v) {
+    return __crc32cd(crc, v);
+}
+inline uint32_t hw_u8(uint32_t crc, uint8_t v) {
+    return __crc32cb(crc, v);
+}
+#endif
+
+CRC32C_HW_TARGET uint32_t crc32c_hw(const uint8_t* p, size_t n, uint32_t crc) {
+    uint32_t crc0 = ~crc;
+
+    if (n >= 3 * BLOCK) {
+        const ShiftTables& shift = block_shift();
+        do {
+            uint32_t crc1 = 0, crc2 = 0;
+            const uint8_t* end = p + BLOCK;
+            do {
+                uint64_t a, b, c;
+                std::memcpy(&a, p, 8);
+                std::memcpy(&b, p + BLOCK, 8);
+                std::memcpy(&c, p + 2 * BLOCK, 8);
+                crc0 = hw_u64(crc0, a);
+                crc1 = hw_u64(crc1, b);
+                crc2 = hw_u64(crc2, c);
+                p += 8;
+            } while (p < end);
+            crc0 = shift.shift(crc0) ^ crc1;
+            crc0 = shift.shift(crc0) ^ crc2;
+            p += 2 * BLOCK;
+            n -= 3 * BLOCK;
+        } while (n >= 3 * BLOCK);
+    }
+
+    while (n >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc0 = hw_u64(crc0, word);
+        p += 8;
+        n -= 8;
+    }
+    while (n--) {
+        crc0 = hw_u8(crc0, *p++);
+    }
+    return ~crc0;
+}
+
+#endif // CRC32C_HW_TARGET
+
+bool detect_hardware() {
+#if defined(CRC32C_HW_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+#elif defined(CRC32C_HW_ARM)
+    return true; // compiled for a CPU with the CRC extension
+#else
+    return false;
+#endif
+}
+
+const bool use_hardware = detect_hardware();
+
+} // namespace
+
+uint32_t crc32c(const void* data, size_t length, uint32_t crc) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+#ifdef CRC32C_HW_TARGET
+    if (use_hardware) {
+        return crc32c_hw(p, length, crc);
+    }
+#endif
+    return crc32c_sw(p, length, crc);
+}
+
+bool crc32c_hardware() {
+    return use_hardware;
+}
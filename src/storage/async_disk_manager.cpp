@@ -0,0 +1,362 @@
+#include "storage/async_disk_manager.hpp"
+#include "common/constants.hpp"
+#include "common/trace.hpp"
+#include "storage/page.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <utility>
+#ifdef ADVANCEDB_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+struct AsyncDiskManager::Ring {
+#ifdef ADVANCEDB_HAVE_LIBURING
+    io_uring ring;
+    // prepared entries io_uring_submit has not taken yet, their requests are still ours
+    std::vector<std::pair<io_uring_sqe*, Request*>> unsubmitted;
+#endif
+};
+
+namespace {
+
+inline uint64_t page_offset(uint32_t page_id) {
+    return static_cast<uint64_t>(page_id) * PAGE_SIZE;
+}
+
+inline bool is_aligned(const void* ptr) {
+    return reinterpret_cast<uintptr_t>(ptr) % PAGE_ALIGNMENT == 0;
+}
+
+} // namespace
+
+AsyncDiskManager::AsyncDiskManager(DiskManager& disk_manager, unsigned queue_depth)
+    : dm(disk_manager), depth(queue_depth == 0 ? 1 : queue_depth) {
+    queued.reserve(depth);
+#ifdef ADVANCEDB_HAVE_LIBURING
+    ring = std::make_unique<Ring>();
+    // old kernels, seccomp filters and containers can all refuse io_uring_setup,
+    // the synchronous path still works there
+    if (io_uring_queue_init(depth, &ring->ring, 0) < 0) {
+        ring.reset();
+    }
+#endif
+}
+
+AsyncDiskManager::~AsyncDiskManager() {
+    try {
+        wait_all();
+    }
+    catch (const std::exception&) {
+        // a failed submit during teardown has nowhere to be reported
+    }
+#ifdef ADVANCEDB_HAVE_LIBURING
+    if (ring) {
+        io_uring_queue_exit(&ring->ring);
+    }
+#endif
+}
+
+void AsyncDiskManager::read_page_async(uint32_t page_id, uint8_t* page_data, IoCallback callback) {
+    enqueue({false, page_id, page_data, std::move(callback), nullptr});
+}
+
+void AsyncDiskManager::write_page_async(uint32_t page_id, uint8_t* page_data, IoCallback callback) {
+    enqueue({true, page_id, page_data, std::move(callback), nullptr});
+}
+
+std::future<bool> AsyncDiskManager::read_page_async(uint32_t page_id, uint8_t* page_data) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = promise->get_future();
+    read_page_async(page_id, page_data, [promise](bool ok) { promise->set_value(ok); });
+    return result;
+}
+
+std::future<bool> AsyncDiskManager::write_page_async(uint32_t page_id, uint8_t* page_data) {
+    auto promise = std::make_shared<std::promise<bool>>();
+    std::future<bool> result = promise->get_future();
+    write_page_async(page_id, page_data, [promise](bool ok) { promise->set_value(ok); });
+    return result;
+}
+
+void AsyncDiskManager::enqueue(Request request) {
+    queued.push_back(std::move(request));
+    if (queued.size() >= depth) {
+        submit();
+    }
+}
+
+void AsyncDiskManager::complete(Request& request, bool ok) {
+    if (request.callback) {
+        request.callback(ok);
+    }
+}
+
+// Fallback: run the batch right away through the DiskManager. Consecutive reads (or writes)
+// go down as one vectored call, so adjacent pages still cost one syscall per run.
+size_t AsyncDiskManager::submit_sync() {
+    // callbacks may queue more requests, those go into the next batch
+    std::vector<Request> batch;
+    batch.swap(queued);
+
+    for (size_t first = 0; first < batch.size();) {
+        bool is_write = batch[first].is_write;
+        size_t last = first;
+        std::vector<PageBuffer> pages;
+        while (last < batch.size() && batch[last].is_write == is_write) {
+            pages.push_back({batch[last].page_id, batch[last].buffer});
+            last++;
+        }
+
+        bool ok = true;
+        try {
+            if (is_write) {
+                dm.write_pages(pages);
+            } else {
+                dm.read_pages(pages);
+            }
+        }
+        catch (const std::runtime_error&) {
+            ok = false;
+        }
+
+        for (size_t i = first; i < last; i++) {
+            bool request_ok = ok;
+            if (!ok) {
+                // find out which pages actually failed
+                request_ok = true;
+                try {
+                    if (is_write) {
+                        dm.write_page(batch[i].page_id, batch[i].buffer);
+                    } else {
+                        dm.read_page(batch[i].page_id, batch[i].buffer);
+                    }
+                }
+                catch (const std::runtime_error&) {
+                    request_ok = false;
+                }
+            }
+            complete(batch[i], request_ok);
+        }
+        first = last;
+    }
+    return batch.size();
+}
+
+#ifdef ADVANCEDB_HAVE_LIBURING
+
+size_t AsyncDiskManager::submit() {
+    if (!ring) {
+        return submit_sync();
+    }
+
+    std::vector<Request> batch;
+    batch.swap(queued);
+
+    size_t prepared = 0;
+    size_t next = 0;
+    try {
+        for (; next < batch.size(); next++) {
+            Request& request = batch[next];
+            // keep the completion queue from overflowing, at most depth requests in flight
+            if (in_flight >= depth) {
+                submit_ring();
+                while (in_flight >= depth) {
+                    poll_ring(true);
+                }
+            }
+
+            if (request.is_write) {
+                // same checksum and extent bookkeeping as DiskManager::write_page
+                try {
+                    dm.prepare_write(request.page_id, request.buffer);
+                }
+                catch (const std::runtime_error&) {
+                    complete(request, false);
+                    continue;
+                }
+            }
+
+            io_uring_sqe* sqe = io_uring_get_sqe(&ring->ring);
+            if (!sqe) {
+                submit_ring();
+                sqe = io_uring_get_sqe(&ring->ring);
+                if (!sqe) {
+                    throw std::runtime_error("io_uring submission queue is full");
+                }
+            }
+
+            // the ring hands the pointer back in the completion, which owns it from then on
+            Request* owned = new Request(std::move(request));
+            uint8_t* io_buffer = owned->buffer;
+            if (dm.direct_io() && !is_aligned(io_buffer)) {
+                // O_DIRECT rejects unaligned buffers with EINVAL, bounce like DiskManager does
+                owned->bounce = std::make_unique<Page>();
+                io_buffer = owned->bounce->data;
+                if (owned->is_write) {
+                    std::memcpy(io_buffer, owned->buffer, PAGE_SIZE);
+                }
+            }
+            int fd = dm.native_handle();
+            if (owned->is_write) {
+                io_uring_prep_write(sqe, fd, io_buffer, PAGE_SIZE, page_offset(owned->page_id));
+            } else {
+                io_uring_prep_read(sqe, fd, io_buffer, PAGE_SIZE, page_offset(owned->page_id));
+            }
+            io_uring_sqe_set_data(sqe, owned);
+            ring->unsubmitted.push_back({sqe, owned});
+            in_flight++;
+            prepared++;
+        }
+        submit_ring();
+    }
+    catch (...) {
+        // requests that never reached the ring fail too, the ones in flight complete through poll
+        for (size_t i = next; i < batch.size(); i++) {
+            complete(batch[i], false);
+        }
+        throw;
+    }
+    return prepared;
+}
+
+// Hand the prepared entries to the kernel. When it refuses them they are turned into no-ops
+// without a request (poll_ring drops those) and their requests fail here, none is leaked.
+void AsyncDiskManager::submit_ring() {
+    std::vector<std::pair<io_uring_sqe*, Request*>>& unsubmitted = ring->unsubmitted;
+    int ret = io_uring_submit(&ring->ring);
+    if (ret >= 0) {
+        size_t accepted = std::min<size_t>(static_cast<size_t>(ret), unsubmitted.size());
+        unsubmitted.erase(unsubmitted.begin(), unsubmitted.begin() + accepted);
+        return;
+    }
+
+    std::vector<std::pair<io_uring_sqe*, Request*>> failed;
+    failed.swap(unsubmitted);
+    for (auto& entry : failed) {
+        io_uring_prep_nop(entry.first);
+        io_uring_sqe_set_data(entry.first, nullptr);
+        std::unique_ptr<Request> request(entry.second);
+        in_flight--;
+        complete(*request, false);
+    }
+    throw std::runtime_error("io_uring_submit failed");
+}
+
+size_t AsyncDiskManager::poll() {
+    if (!ring) {
+        return 0;
+    }
+    return poll_ring(false);
+}
+
+// Reap completions, blocking for the first one when wait is set
+size_t AsyncDiskManager::poll_ring(bool wait) {
+    std::vector<std::pair<std::unique_ptr<Request>, bool>> done;
+    bool wrote = false;
+    while (in_flight > 0) {
+        io_uring_cqe* cqe = nullptr;
+        int ret = (wait && done.empty()) ? io_uring_wait_cqe(&ring->ring, &cqe)
+                                         : io_uring_peek_cqe(&ring->ring, &cqe);
+        if (ret == -EINTR) {
+            continue;
+        }
+        if (ret < 0 || !cqe) {
+            if (wait && done.empty() && ret != -EAGAIN) {
+                throw std::runtime_error("io_uring_wait_cqe failed");
+            }
+            break; // -EAGAIN: nothing ready
+        }
+
+        auto* owned = static_cast<Request*>(io_uring_cqe_get_data(cqe));
+        int res = cqe->res;
+        io_uring_cqe_seen(&ring->ring, cqe);
+        if (!owned) {
+            continue; // a no-op left behind by a failed submit
+        }
+        std::unique_ptr<Request> request(owned);
+        in_flight--;
+
+        bool ok;
+        if (request->is_write) {
+            ok = res == static_cast<int>(PAGE_SIZE);
+            if (ok) {
+                trace_io(IoOp::WRITE, request->page_id, PAGE_SIZE);
+                wrote = true;
+            }
+        } else {
+            // short read only happens at EOF, the rest of the page reads as zeroes like read_page
+            ok = res >= 0;
+            if (ok) {
+                if (request->bounce) {
+                    std::memcpy(request->buffer, request->bounce->data, res);
+                }
+                if (res < static_cast<int>(PAGE_SIZE)) {
+                    std::memset(request->buffer + res, 0, PAGE_SIZE - res);
+                }
+                ok = res == 0 || verify_page_checksum(request->buffer);
+                trace_io(IoOp::READ, request->page_id, PAGE_SIZE);
+            }
+        }
+        done.emplace_back(std::move(request), ok);
+    }
+
+    // like write_pages, the writes reaped together count once for the sync policy, and it is
+    // applied before any callback sees its write as done
+    if (wrote) {
+        bool synced = true;
+        try {
+            dm.write_completed();
+        }
+        catch (const std::runtime_error&) {
+            synced = false;
+        }
+        for (auto& entry : done) {
+            if (entry.first->is_write && !synced) {
+                entry.second = false;
+            }
+        }
+    }
+    for (auto& entry : done) {
+        complete(*entry.first, entry.second);
+    }
+    return done.size();
+}
+
+void AsyncDiskManager::wait_all() {
+    if (!ring) {
+        while (!queued.empty()) {
+            submit_sync();
+        }
+        return;
+    }
+    // callbacks may queue follow-up requests, keep going until both are drained
+    while (!queued.empty() || in_flight > 0) {
+        submit();
+        while (in_flight > 0) {
+            if (!ring->unsubmitted.empty()) {
+                submit_ring(); // left over from a partial submit
+            }
+            poll_ring(true);
+        }
+    }
+}
+
+#else
+
+size_t AsyncDiskManager::submit() {
+    return submit_sync();
+}
+
+size_t AsyncDiskManager::poll() {
+    return 0; // everything completed inside submit()
+}
+
+void AsyncDiskManager::wait_all() {
+    while (!queued.empty()) {
+        submit_sync();
+    }
+}
+
+#endif
@@ -0,0 +1,191 @@
+#include <cstdint>
+#include "storage/page.hpp"
+#include "storage/btree.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/record.hpp"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+// Batch positions ordered by key, later duplicates of a key dropped
+std::vector<size_t> sorted_order(const std::vector<BatchEntry>& batch) {
+    std::vector<size_t> order(batch.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const Key& ka = batch[a].key;
+        const Key& kb = batch[b].key;
+        return compare_keys(ka.data, ka.size, kb.data, kb.size) < 0;
+    });
+    auto last = std::unique(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const Key& ka = batch[a].key;
+        const Key& kb = batch[b].key;
+        return compare_keys(ka.data, ka.size, kb.data, kb.size) == 0;
+    });
+    order.erase(last, order.end());
+    return order;
+}
+
+// find_leaf_page that also reports the leaf's upper bound: the separator right of the path at
+// the lowest level that has one. Keys below it belong to this leaf. bounded is false for the
+// rightmost leaf.
+PageGuard find_leaf_with_bound(TableHandle& th, const Key& key, std::vector<uint8_t>& high, bool& bounded) {
+    bounded = false;
+    uint32_t page_id = th.root_page;
+    for (int depth = 0; depth <= 100; depth++) {
+        PageGuard guard = fetch_read_page(th, page_id);
+        if (!guard.valid()) {
+            return PageGuard();
+        }
+        Page& page = guard.page();
+        auto* ph = get_header(page);
+        if (ph->page_level == PageLevel::LEAF) {
+            return guard;
+        }
+
+        // first separator greater than key, the child left of it holds key
+        BSearchResult sr = search_internal(page, key.data, key.size);
+        uint16_t pos = sr.found ? sr.index + 1 : sr.index;
+        if (pos < ph->cell_count) {
+            uint16_t high_len;
+            const uint8_t* high_key = internal_key(page, pos, high_len);
+            high.assign(high_key, high_key + high_len);
+            bounded = true;
+        }
+
+        page_id = internal_find_child(page, key);
+        if (page_id == 0 || page_id == INVALID_PAGE_ID) {
+            return PageGuard();
+        }
+    }
+    return PageGuard();
+}
+
+} // namespace
+
+size_t btree_insert_batch(TableHandle& th, const std::vector<BatchEntry>& batch) {
+    if (th.read_only() || batch.empty()) {
+        return 0;
+    }
+
+    std::vector<size_t> order = sorted_order(batch);
+    size_t inserted = 0;
+    size_t i = 0;
+
+    if (th.root_page == 0) {
+        const BatchEntry& first = batch[order[i++]];
+        inserted += btree_insert(th, first.key, first.value) ? 1 : 0;
+    }
+
+    std::vector<uint8_t> high;
+    while (i < order.size()) {
+        bool bounded;
+        PageGuard leaf = find_leaf_with_bound(th, batch[order[i]].key, high, bounded);
+        if (!leaf.valid()) {
+            break;
+        }
+
+        // every key up to the leaf's bound goes in while the leaf stays pinned
+        while (i < order.size()) {
+            const BatchEntry& entry = batch[order[i]];
+            if (bounded && compare_keys(entry.key.data, entry.key.size, high.data(),
+                                        static_cast<uint16_t>(high.size())) >= 0) {
+                break; // belongs to a leaf further right
+            }
+            if (entry.key.size > MAX_KEY_SIZE ||
+                search_record(leaf.page(), entry.key.data, entry.key.size).found) {
+                i++;
+                continue;
+            }
+            if (!needs_overflow(entry.value) && btree_insert_leaf_no_split(leaf, entry.key, entry.value)) {
+                inserted++;
+                i++;
+                continue;
+            }
+            // the leaf is full or the value needs overflow pages: insert it the usual way, then
+            // descend again for the rest
+            leaf = PageGuard();
+            inserted += btree_insert(th, entry.key, entry.value) ? 1 : 0;
+            i++;
+            break;
+        }
+    }
+    return inserted;
+}
+
+std::vector<MultiGetResult> btree_multi_get(TableHandle& th, const std::vector<Key>& keys) {
+    std::vector<MultiGetResult> results(keys.size());
+    if (th.root_page == 0 || keys.empty()) {
+        return results;
+    }
+
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return compare_keys(keys[a].data, keys[a].size, keys[b].data, keys[b].size) < 0;
+    });
+
+    // The current root-to-leaf path, each node pinned with the upper bound of its key range.
+    // The next (larger) key climbs only until a node's range covers it and descends from there.
+    struct PathNode {
+        PageGuard guard;
+        std::vector<uint8_t> high;
+        bool bounded;
+    };
+    std::vector<PathNode> path;
+
+    for (size_t index : order) {
+        const Key& key = keys[index];
+        while (!path.empty() && path.back().bounded &&
+               compare_keys(key.data, key.size, path.back().high.data(),
+                            static_cast<uint16_t>(path.back().high.size())) >= 0) {
+            path.pop_back();
+        }
+        if (path.empty()) {
+            PageGuard root = fetch_read_page(th, th.root_page);
+            if (!root.valid()) {
+                return results;
+            }
+            path.push_back({std::move(root), {}, false});
+        }
+
+        while (get_header(path.back().guard.page())->page_level == PageLevel::INTERNAL) {
+            if (path.size() > 100) {
+                return results; // corrupt tree
+            }
+            PathNode& parent = path.back();
+            Page& page = parent.guard.page();
+            BSearchResult sr = search_internal(page, key.data, key.size);
+            uint16_t pos = sr.found ? sr.index + 1 : sr.index;
+
+            PathNode child{PageGuard(), parent.high, parent.bounded};
+            if (pos < get_header(page)->cell_count) {
+                uint16_t high_len;
+                const uint8_t* high_key = internal_key(page, pos, high_len);
+                child.high.assign(high_key, high_key + high_len);
+                child.bounded = true;
+            }
+            uint32_t child_id = internal_find_child(page, key);
+            if (child_id == 0 || child_id == INVALID_PAGE_ID) {
+                return results;
+            }
+            child.guard = fetch_read_page(th, child_id);
+            if (!child.guard.valid()) {
+                return results;
+            }
+            path.push_back(std::move(child));
+        }
+
+        Page& leaf = path.back().guard.page();
+        BSearchResult sr = search_record(leaf, key.data, key.size);
+        if (sr.found) {
+            Value value = record_value(th, leaf, sr.index, results[index].value);
+            if (value.data != nullptr && value.data != results[index].value.data()) {
+                results[index].value.assign(value.data, value.data + value.size);
+            }
+            results[index].found = value.data != nullptr;
+        }
+    }
+    return results;
+}
@@ -0,0 +1,268 @@
+#include <cstdint>
+#include "storage/page.hpp"
+#include "storage/btree.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/record.hpp"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t PAGE_CAPACITY = PAGE_DATA_END - sizeof(PageHeader);
+// finished pages are written in batches of this many, allocation keeps them mostly adjacent
+constexpr size_t WRITE_BATCH = 64;
+
+// Builds the tree left to right. Only the rightmost node of every level is open (in memory);
+// when one fills up it is written out and the next node of that level is linked into the
+// level above, which is created the first time a level needs a second node.
+class BulkLoader {
+public:
+    BulkLoader(TableHandle& th, double fill_factor)
+        : th(th),
+          target(static_cast<uint32_t>(PAGE_CAPACITY * std::clamp(fill_factor, 0.1, 1.0))) {}
+
+    // first leaf goes into first_page (the empty root) when there is one
+    void start(uint32_t first_page);
+    bool add(const Key& key, const Value& value);
+    uint32_t finish();
+    void abort(uint32_t first_page);
+    bool empty() const { return get_header(*open[0])->cell_count == 0; }
+
+private:
+    uint32_t allocate(PageLevel level, uint32_t near);
+    bool fits(Page& page, uint16_t size) const;
+    Value spill(const Value& value);
+    void add_child(size_t level, const Key& key, uint32_t child);
+    void close_node(size_t level);
+    void write(Page& page);
+    void flush_writes();
+
+    TableHandle& th;
+    uint32_t target;                         // fill limit in bytes of cells and slots
+    std::vector<std::unique_ptr<Page>> open; // open node per level, 0 = leaves
+    std::vector<std::unique_ptr<Page>> pending;
+    std::vector<uint32_t> allocated;
+    std::vector<uint8_t> last_key;
+    std::vector<uint8_t> stub_buf;
+    std::vector<uint8_t> separator_buf;
+};
+
+uint32_t BulkLoader::allocate(PageLevel level, uint32_t near) {
+    uint32_t page_id = allocate_page(th, level, near);
+    if (page_id == INVALID_PAGE_ID) {
+        throw std::runtime_error("Bulk load ran out of page ids");
+    }
+    allocated.push_back(page_id);
+    // a freed page may still sit in the pool, its stale copy must not be written over ours
+    if (!th.bpm.discard_page(page_id)) {
+        throw std::runtime_error("Bulk load page " + std::to_string(page_id) + " is pinned");
+    }
+    return page_id;
+}
+
+// The first cell always goes in, otherwise stay within the fill target
+bool BulkLoader::fits(Page& page, uint16_t size) const {
+    auto* ph = get_header(page);
+    if (ph->cell_count == 0) {
+        return true;
+    }
+    uint32_t used = (ph->free_start - sizeof(PageHeader)) + ph->cell_count * sizeof(uint16_t);
+    return used + size + sizeof(uint16_t) <= target && can_insert(page, size);
+}
+
+// Write value's overflow chain with the other pages, returns the stub for the leaf
+Value BulkLoader::spill(const Value& value) {
+    std::vector<uint32_t> pages(overflow_page_count(value.size));
+    uint32_t near = INVALID_PAGE_ID;
+    for (uint32_t& page_id : pages) {
+        page_id = allocate(PageLevel::NONE, near);
+        near = page_id;
+    }
+    Page page;
+    for (uint32_t i = 0; i < pages.size(); i++) {
+        init_overflow_page(page, pages[i], i + 1 < pages.size() ? pages[i + 1] : 0, value, i);
+        write(page);
+    }
+    return overflow_stub(value, pages[0], stub_buf);
+}
+
+void BulkLoader::start(uint32_t first_page) {
+    uint32_t page_id = first_page;
+    if (page_id == 0) {
+        page_id = allocate(PageLevel::LEAF, INVALID_PAGE_ID);
+    } else if (!th.bpm.discard_page(page_id)) {
+        throw std::runtime_error("Bulk load page " + std::to_string(page_id) + " is pinned");
+    }
+    open.push_back(std::make_unique<Page>());
+    init_page(*open[0], page_id, PageType::DATA, PageLevel::LEAF);
+}
+
+bool BulkLoader::add(const Key& key, const Value& value) {
+    if (!last_key.empty() || !empty()) {
+        if (compare_keys(key.data, key.size, last_key.data(), static_cast<uint16_t>(last_key.size())) <= 0) {
+            return false; // not strictly ascending
+        }
+    }
+    if (key.size > MAX_KEY_SIZE) {
+        return false;
+    }
+    uint8_t flags = 0;
+    Value stored = value;
+    if (needs_overflow(value)) {
+        stored = spill(value);
+        flags = RECORD_OVERFLOW;
+    }
+    // records are only appended, so the leaf holds no dead space; the first one always goes in
+    Page* leaf = open[0].get();
+    auto* ph = get_header(*leaf);
+    uint32_t used = (ph->free_start - sizeof(PageHeader)) + ph->cell_count * sizeof(uint16_t);
+    if (ph->cell_count > 0 && leaf_bytes_with(*leaf, used, key.data, key.size, stored.size) > target) {
+        uint32_t old_id = get_header(*leaf)->page_id;
+        uint32_t new_id = allocate(PageLevel::LEAF, old_id);
+        set_leaf_next(*leaf, new_id);
+        close_node(0);
+
+        init_page(*leaf, new_id, PageType::DATA, PageLevel::LEAF);
+        set_leaf_prev(*leaf, old_id);
+        // the new leaf's separator is the shortest key above the previous leaf's last
+        shortest_separator({last_key.data(), static_cast<uint16_t>(last_key.size())}, key, separator_buf);
+        add_child(1, {separator_buf.data(), static_cast<uint16_t>(separator_buf.size())}, new_id);
+    }
+
+    // the leaf's prefix shrinks to what the keys so far share
+    if (!page_insert(*leaf, key.data, key.size, stored.data, stored.size, flags)) {
+        throw std::runtime_error("Bulk load failed to insert a record into its leaf");
+    }
+    last_key.assign(key.data, key.data + key.size);
+    return true;
+}
+
+// child (whose first key is key) goes into the open node of level
+void BulkLoader::add_child(size_t level, const Key& key, uint32_t child) {
+    Page* node = open[level].get();
+    uint16_t size = sizeof(InternalEntry) + key.size;
+    if (fits(*node, size)) {
+        uint16_t offset = write_internal_entry(*node, key, child);
+        insert_slot(*node, get_header(*node)->cell_count, offset);
+        return;
+    }
+
+    // key becomes the separator in the level above, child the leftmost of a new node
+    uint32_t new_id = allocate(PageLevel::INTERNAL, get_header(*node)->page_id);
+    close_node(level);
+    init_page(*node, new_id, PageType::INDEX, PageLevel::INTERNAL);
+    memcpy(get_header(*node)->reserved, &child, sizeof(child));
+    add_child(level + 1, key, new_id);
+}
+
+// Write the open node of level. The first time a level closes a node the level above is
+// created, with that node as its leftmost child.
+void BulkLoader::close_node(size_t level) {
+    Page& node = *open[level];
+    if (open.size() == level + 1) {
+        uint32_t page_id = get_header(node)->page_id;
+        uint32_t parent_id = allocate(PageLevel::INTERNAL, INVALID_PAGE_ID);
+        auto parent = std::make_unique<Page>();
+        init_page(*parent, parent_id, PageType::INDEX, PageLevel::INTERNAL);
+        memcpy(get_header(*parent)->reserved, &page_id, sizeof(page_id));
+        open.push_back(std::move(parent));
+    }
+    write(node);
+}
+
+void BulkLoader::write(Page& page) {
+    auto copy = std::make_unique<Page>();
+    memcpy(copy->data, page.data, PAGE_SIZE);
+    pending.push_back(std::move(copy));
+    if (pending.size() >= WRITE_BATCH) {
+        flush_writes();
+    }
+}
+
+// write_pages sorts the batch and coalesces adjacent ids into vectored writes
+void BulkLoader::flush_writes() {
+    std::vector<PageBuffer> batch;
+    batch.reserve(pending.size());
+    for (auto& page : pending) {
+        batch.push_back({get_header(*page)->page_id, page->data});
+    }
+    th.dm.write_pages(batch);
+    pending.clear();
+}
+
+// Write out the rightmost node of every level, the top one is the root
+uint32_t BulkLoader::finish() {
+    for (size_t level = 0; level + 1 < open.size(); level++) {
+        write(*open[level]);
+    }
+    Page& root = *open.back();
+    auto* root_ph = get_header(root);
+    if (root_ph->page_level == PageLevel::INTERNAL) {
+        memcpy(&root_ph->root_page, root_ph->reserved, sizeof(uint32_t)); // see create_new_root
+    }
+    write(root);
+    flush_writes();
+    return root_ph->page_id;
+}
+
+// Give back every page taken so far and leave first_page an empty leaf again
+void BulkLoader::abort(uint32_t first_page) {
+    pending.clear();
+    for (uint32_t page_id : allocated) {
+        free_page(th, page_id);
+    }
+    if (first_page != 0) {
+        Page empty_leaf;
+        init_page(empty_leaf, first_page, PageType::DATA, PageLevel::LEAF);
+        th.dm.write_page(first_page, empty_leaf.data);
+    }
+}
+
+} // namespace
+
+bool btree_bulk_load(TableHandle& th, const BulkLoadSource& next, double fill_factor) {
+    if (th.read_only()) {
+        return false;
+    }
+
+    // only into an empty tree: no root yet, or an empty root leaf
+    uint32_t first_page = th.root_page;
+    if (first_page != 0) {
+        PageGuard root = th.bpm.fetch_page_guard(first_page);
+        auto* ph = get_header(root.page());
+        if (ph->page_level != PageLevel::LEAF || ph->cell_count != 0) {
+            return false;
+        }
+    }
+
+    BulkLoader loader(th, fill_factor);
+    try {
+        loader.start(first_page);
+        Key key;
+        Value value;
+        while (next(key, value)) {
+            if (!loader.add(key, value)) {
+                loader.abort(first_page);
+                return false;
+            }
+        }
+    } catch (...) {
+        loader.abort(first_page);
+        throw;
+    }
+    if (loader.empty()) {
+        loader.abort(first_page);
+        return true; // nothing to load, the tree stays empty
+    }
+
+    uint32_t root_id = loader.finish();
+    th.root_page = root_id;
+    PageGuard meta = th.bpm.fetch_page_guard(0);
+    get_header(meta.page())->root_page = root_id;
+    meta.mark_dirty();
+    return true;
+}
@@ -0,0 +1,138 @@
+#include <cstdint>
+#include "storage/page.hpp"
+#include "storage/btree.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/record.hpp"
+
+bool BTreeCursor::seek(const Key& key) {
+    leaf = PageGuard();
+    if (th->root_page == 0) {
+        return false; // Empty tree
+    }
+
+    leaf = find_leaf_page(*th, key);
+    if (!leaf.valid()) {
+        return false;
+    }
+    // not found: index is where the key would go, i.e. the first larger key
+    index = search_record(leaf.page(), key.data, key.size).index;
+    return settle();
+}
+
+bool BTreeCursor::seek_first() {
+    static const uint8_t none = 0;
+    return seek({&none, 0}); // the empty key sorts before every other key
+}
+
+bool BTreeCursor::seek_for_prev(const Key& key) {
+    leaf = PageGuard();
+    if (th->root_page == 0) {
+        return false;
+    }
+
+    leaf = find_leaf_page(*th, key);
+    if (!leaf.valid()) {
+        return false;
+    }
+    BSearchResult result = search_record(leaf.page(), key.data, key.size);
+    if (result.found) {
+        index = result.index;
+        return true;
+    }
+    // the last smaller key sits just before the insert position, maybe in the previous leaf
+    index = result.index;
+    return settle_back();
+}
+
+bool BTreeCursor::seek_last() {
+    leaf = PageGuard();
+    if (th->root_page == 0) {
+        return false;
+    }
+
+    // rightmost descent: the last entry's child, or the leftmost child of an empty node
+    uint32_t page_id = th->root_page;
+    for (int depth = 0; depth <= 100; depth++) {
+        leaf = fetch_read_page(*th, page_id);
+        if (!leaf.valid()) {
+            return false;
+        }
+        Page& page = leaf.page();
+        auto* ph = get_header(page);
+        if (ph->page_level == PageLevel::LEAF) {
+            index = ph->cell_count;
+            return settle_back();
+        }
+        if (ph->cell_count == 0) {
+            page_id = *reinterpret_cast<uint32_t*>(ph->reserved);
+        } else {
+            auto* entry = reinterpret_cast<InternalEntry*>(page.data + *slot_ptr(page, ph->cell_count - 1));
+            page_id = entry->child_page;
+        }
+        if (page_id == 0 || page_id == INVALID_PAGE_ID) {
+            break;
+        }
+    }
+    leaf = PageGuard(); // corrupt tree
+    return false;
+}
+
+bool BTreeCursor::next() {
+    if (!leaf.valid()) {
+        return false;
+    }
+    index++;
+    return settle();
+}
+
+// Step over the end of the current leaf (and any empty leaves) to the next record
+bool BTreeCursor::settle() {
+    while (index >= get_header(leaf.page())->cell_count) {
+        uint32_t next_page_id = leaf_next(leaf.page());
+        if (next_page_id == 0) {
+            leaf = PageGuard();
+            return false;
+        }
+        // reassigning the guard unpins the leaf we are leaving
+        leaf = fetch_read_page(*th, next_page_id);
+        if (!leaf.valid()) {
+            return false;
+        }
+        index = 0;
+    }
+    return true;
+}
+
+bool BTreeCursor::prev() {
+    if (!leaf.valid()) {
+        return false;
+    }
+    return settle_back();
+}
+
+// Step to the record before index, going back through the prev links when it is 0
+bool BTreeCursor::settle_back() {
+    while (index == 0) {
+        uint32_t prev_page_id = leaf_prev(leaf.page());
+        if (prev_page_id == 0) {
+            leaf = PageGuard();
+            return false;
+        }
+        leaf = fetch_read_page(*th, prev_page_id);
+        if (!leaf.valid()) {
+            return false;
+        }
+        index = get_header(leaf.page())->cell_count;
+    }
+    index--;
+    return true;
+}
+
+Key BTreeCursor::key() {
+    slot_key(leaf.page(), index, key_buf);
+    return {key_buf.data(), static_cast<uint16_t>(key_buf.size())};
+}
+
+Value BTreeCursor::value() {
+    return record_value(*th, leaf.page(), index, value_buf);
+}
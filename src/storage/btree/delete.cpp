@@ -0,0 +1,341 @@
+#include <cstdint>
+#include "storage/page.hpp"
+#include "storage/btree.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/record.hpp"
+#include <cstring>
+#include <vector>
+#include <cassert>
+
+namespace {
+
+// usable bytes of a page, everything between the header and the trailer
+constexpr uint32_t PAGE_CAPACITY = PAGE_DATA_END - sizeof(PageHeader);
+// a node with fewer live bytes than this borrows from or merges with a sibling
+constexpr uint32_t MIN_FILL = PAGE_CAPACITY / 4;
+
+struct PathEntry {
+    uint32_t page_id;
+    uint16_t child_index; // 0 = leftmost child, i = child of entry i - 1
+};
+
+// A leaf record or an internal entry copied out of its page while two siblings are rebuilt
+struct Cell {
+    std::vector<uint8_t> key;   // leaf records: the full key, page prefix included
+    std::vector<uint8_t> value; // leaf records only
+    uint8_t flags{0};           // leaf records only
+    uint32_t child{0};          // internal entries only
+};
+
+// size of a cell and its slot, a leaf record counted without a page prefix
+uint32_t cell_bytes(const Cell& cell, bool leaf) {
+    return (leaf ? record_size(cell.key.size(), cell.value.size()) : sizeof(InternalEntry) + cell.key.size()) +
+           sizeof(uint16_t);
+}
+
+// Prefix the keys of cells [from, to) share, a leaf stores it once instead of in every record
+uint32_t shared_prefix(const std::vector<Cell>& cells, size_t from, size_t to, bool leaf) {
+    if (!leaf || from >= to) {
+        return 0;
+    }
+    const std::vector<uint8_t>& first = cells[from].key;
+    const std::vector<uint8_t>& last = cells[to - 1].key;
+    uint32_t len = 0;
+    while (len < first.size() && len < last.size() && first[len] == last[len]) {
+        len++;
+    }
+    return len;
+}
+
+InternalEntry* internal_entry(Page& page, uint16_t index) {
+    return reinterpret_cast<InternalEntry*>(page.data + *slot_ptr(page, index));
+}
+
+uint32_t leftmost_child(Page& page) {
+    uint32_t child;
+    memcpy(&child, get_header(page)->reserved, sizeof(child));
+    return child;
+}
+
+void set_leftmost_child(Page& page, uint32_t child) {
+    memcpy(get_header(page)->reserved, &child, sizeof(child));
+}
+
+// Same rule as internal_find_child: the number of keys <= key
+uint16_t child_index(Page& page, const Key& key) {
+    uint16_t left = 0;
+    uint16_t right = get_header(page)->cell_count;
+    while (left < right) {
+        uint16_t mid = left + (right - left) / 2;
+        uint16_t mid_len;
+        const uint8_t* mid_key = internal_key(page, mid, mid_len);
+        if (compare_keys(key.data, key.size, mid_key, mid_len) < 0) {
+            right = mid;
+        } else {
+            left = mid + 1;
+        }
+    }
+    return left;
+}
+
+uint32_t child_at(Page& page, uint16_t index) {
+    return index == 0 ? leftmost_child(page) : internal_entry(page, index - 1)->child_page;
+}
+
+// Empty the body of an internal page, keeping the header (ids, level, leftmost child)
+void clear_cells(Page& page) {
+    auto* ph = get_header(page);
+    memset(page.data + sizeof(PageHeader), 0, PAGE_SIZE - sizeof(PageHeader));
+    ph->cell_count = 0;
+    ph->free_start = sizeof(PageHeader);
+    ph->free_end = PAGE_DATA_END;
+}
+
+void append_cell(Page& page, const Cell& cell, bool leaf) {
+    uint16_t offset;
+    if (leaf) {
+        offset = write_record(page, cell.key.data(), static_cast<uint16_t>(cell.key.size()), cell.value.data(),
+                              static_cast<uint16_t>(cell.value.size()), cell.flags);
+    } else {
+        offset = write_internal_entry(page, {cell.key.data(), static_cast<uint16_t>(cell.key.size())}, cell.child);
+    }
+    insert_slot(page, get_header(page)->cell_count, offset);
+}
+
+// Rewrite page's body with cells [from, to)
+void fill_page(Page& page, const std::vector<Cell>& cells, size_t from, size_t to, bool leaf) {
+    if (leaf) {
+        uint32_t prefix_len = shared_prefix(cells, from, to, leaf);
+        clear_leaf(page, from < to ? cells[from].key.data() : nullptr, static_cast<uint16_t>(prefix_len));
+    } else {
+        clear_cells(page);
+    }
+    for (size_t i = from; i < to; i++) {
+        append_cell(page, cells[i], leaf);
+    }
+}
+
+void collect_cells(Page& page, std::vector<Cell>& cells) {
+    bool leaf = get_header(page)->page_level == PageLevel::LEAF;
+    for (uint16_t i = 0; i < get_header(page)->cell_count; i++) {
+        Cell cell;
+        const uint8_t* start = page.data + *slot_ptr(page, i);
+        if (leaf) {
+            slot_key(page, i, cell.key);
+            uint16_t value_len;
+            const uint8_t* value = slot_value(page, i, value_len);
+            cell.value.assign(value, value + value_len);
+            cell.flags = reinterpret_cast<const RecordHeader*>(start)->flags;
+        } else {
+            auto* entry = reinterpret_cast<const InternalEntry*>(start);
+            cell.key.assign(entry->key, entry->key + entry->key_size);
+            cell.child = entry->child_page;
+        }
+        cells.push_back(std::move(cell));
+    }
+}
+
+// Key of internal entry index replaced, its child kept. False if the page can't hold it.
+bool replace_internal_key(Page& page, uint16_t index, const std::vector<uint8_t>& key) {
+    uint32_t old_size = cell_size(page, index);
+    if (live_bytes(page) - old_size + sizeof(InternalEntry) + key.size() > PAGE_CAPACITY) {
+        return false;
+    }
+    uint32_t child = internal_entry(page, index)->child_page;
+    remove_slot(page, index);
+    truncate_page(page, get_header(page)->cell_count);
+    uint16_t offset = write_internal_entry(page, {key.data(), static_cast<uint16_t>(key.size())}, child);
+    insert_slot(page, index, offset);
+    return true;
+}
+
+void release_node(TableHandle& th, PageGuard& guard) {
+    uint32_t page_id = guard.page_id();
+    init_page(guard.page(), page_id, PageType::FREE, PageLevel::NONE);
+    guard.mark_dirty();
+    free_page(th, page_id);
+}
+
+// Siblings left and right (child r - 1 and r of parent) hold too little between them or one
+// of them is underfull. Everything goes into left when it fits, otherwise the cells are split
+// evenly again. Returns true if the parent lost an entry.
+bool merge_or_redistribute(TableHandle& th, PageGuard& parent_guard, uint16_t r) {
+    Page& parent = parent_guard.page();
+    PageGuard left_guard = th.bpm.fetch_page_guard(child_at(parent, r - 1));
+    PageGuard right_guard = th.bpm.fetch_page_guard(child_at(parent, r));
+    Page& left = left_guard.page();
+    Page& right = right_guard.page();
+    bool leaf = get_header(left)->page_level == PageLevel::LEAF;
+
+    // internal nodes: the separator comes down between the two halves, with right's leftmost child
+    std::vector<Cell> cells;
+    collect_cells(left, cells);
+    size_t left_count = cells.size();
+    if (!leaf) {
+        uint16_t sep_len;
+        const uint8_t* sep = internal_key(parent, r - 1, sep_len);
+        Cell down;
+        down.key.assign(sep, sep + sep_len);
+        down.child = leftmost_child(right);
+        cells.push_back(std::move(down));
+    }
+    collect_cells(right, cells);
+
+    uint32_t total = 0;
+    for (const Cell& cell : cells) {
+        total += cell_bytes(cell, leaf);
+    }
+
+    if (total - (cells.size() - 1) * shared_prefix(cells, 0, cells.size(), leaf) <= PAGE_CAPACITY) {
+        fill_page(left, cells, 0, cells.size(), leaf);
+        if (leaf) {
+            uint32_t next = leaf_next(right);
+            set_leaf_next(left, next);
+            if (next != 0) {
+                PageGuard next_guard = th.bpm.fetch_page_guard(next);
+                set_leaf_prev(next_guard.page(), left_guard.page_id());
+                next_guard.mark_dirty();
+            }
+        }
+        left_guard.mark_dirty();
+
+        remove_slot(parent, r - 1);
+        truncate_page(parent, get_header(parent)->cell_count);
+        parent_guard.mark_dirty();
+
+        release_node(th, right_guard);
+        return true;
+    }
+
+    // Split point closest to half the bytes. Leaves: right starts at cells[m], which becomes the
+    // separator. Internal: cells[m] goes up, its child becomes right's leftmost.
+    size_t m = 1;
+    uint32_t best = UINT32_MAX;
+    uint32_t running = 0;
+    for (size_t i = 0; i < cells.size(); i++) {
+        uint32_t size = cell_bytes(cells[i], leaf);
+        uint32_t left_bytes = running;
+        uint32_t right_bytes = total - running - (leaf ? 0 : size);
+        running += size;
+        if (i == 0 || i + (leaf ? 0 : 1) >= cells.size()) {
+            continue; // both halves keep at least one cell
+        }
+        left_bytes -= (i - 1) * shared_prefix(cells, 0, i, leaf);
+        right_bytes -= (cells.size() - i - 1) * shared_prefix(cells, i, cells.size(), leaf);
+        if (left_bytes > PAGE_CAPACITY || right_bytes > PAGE_CAPACITY) {
+            continue;
+        }
+        uint32_t diff = left_bytes > right_bytes ? left_bytes - right_bytes : right_bytes - left_bytes;
+        if (diff < best) {
+            best = diff;
+            m = i;
+        }
+    }
+    if (best == UINT32_MAX || m == left_count) {
+        return false; // nothing to gain
+    }
+
+    // a leaf separator only has to fall between the halves, the shortest such key will do
+    std::vector<uint8_t> separator = cells[m].key;
+    if (leaf) {
+        const std::vector<uint8_t>& last = cells[m - 1].key;
+        shortest_separator({last.data(), static_cast<uint16_t>(last.size())},
+                           {cells[m].key.data(), static_cast<uint16_t>(cells[m].key.size())}, separator);
+    }
+    // the parent has to take the new separator, otherwise leave the pair as it is
+    if (!replace_internal_key(parent, r - 1, separator)) {
+        return false;
+    }
+    parent_guard.mark_dirty();
+
+    fill_page(left, cells, 0, m, leaf);
+    fill_page(right, cells, leaf ? m : m + 1, cells.size(), leaf);
+    if (!leaf) {
+        set_leftmost_child(right, cells[m].child);
+    }
+    left_guard.mark_dirty();
+    right_guard.mark_dirty();
+    return false;
+}
+
+// An internal root left with a single child hands the root over to it
+void collapse_root(TableHandle& th) {
+    PageGuard root = th.bpm.fetch_page_guard(th.root_page);
+    auto* ph = get_header(root.page());
+    if (ph->page_level != PageLevel::INTERNAL || ph->cell_count != 0) {
+        return;
+    }
+    uint32_t child = leftmost_child(root.page());
+
+    PageGuard child_guard = th.bpm.fetch_page_guard(child);
+    auto* child_ph = get_header(child_guard.page());
+    if (child_ph->page_level == PageLevel::INTERNAL) {
+        child_ph->root_page = leftmost_child(child_guard.page()); // see create_new_root
+    }
+    child_guard.mark_dirty();
+
+    th.root_page = child;
+    PageGuard meta = th.bpm.fetch_page_guard(0);
+    get_header(meta.page())->root_page = child;
+    meta.mark_dirty();
+
+    release_node(th, root);
+}
+
+} // namespace
+
+bool btree_delete(TableHandle& th, const Key& key) {
+    if (th.read_only() || th.root_page == 0) {
+        return false;
+    }
+
+    // remember the way down, the rebalancing walks back up it
+    std::vector<PathEntry> path;
+    uint32_t page_id = th.root_page;
+    {
+        PageGuard node = th.bpm.fetch_page_guard(page_id);
+        while (get_header(node.page())->page_level == PageLevel::INTERNAL) {
+            uint16_t index = child_index(node.page(), key);
+            path.push_back({page_id, index});
+            page_id = child_at(node.page(), index);
+            if (page_id == 0 || page_id == INVALID_PAGE_ID || path.size() > 100) {
+                return false;
+            }
+            node = th.bpm.fetch_page_guard(page_id);
+        }
+
+        BSearchResult sr = search_record(node.page(), key.data, key.size);
+        if (!sr.found) {
+            return false;
+        }
+        free_overflow(th, node.page(), sr.index);
+        page_delete(node.page(), key.data, key.size);
+        node.mark_dirty();
+    }
+
+    while (!path.empty()) {
+        {
+            PageGuard node = th.bpm.fetch_page_guard(page_id);
+            if (live_bytes(node.page()) >= MIN_FILL) {
+                return true;
+            }
+        }
+
+        PathEntry up = path.back();
+        path.pop_back();
+        PageGuard parent = th.bpm.fetch_page_guard(up.page_id);
+        if (get_header(parent.page())->cell_count == 0) {
+            return true; // no sibling to work with
+        }
+        // pair with the left sibling, the leftmost child pairs with its right one
+        uint16_t r = up.child_index > 0 ? up.child_index : 1;
+        if (!merge_or_redistribute(th, parent, r)) {
+            return true;
+        }
+        page_id = up.page_id;
+    }
+
+    // page_id is the root now, it may have lost its last separator
+    collapse_root(th);
+    return true;
+}
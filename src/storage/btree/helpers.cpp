@@ -3,6 +3,7 @@
 #include "storage/btree.hpp"
 #include "storage/table_handle.hpp"
 #include "storage/record.hpp"
+#include <cstring>
 #include <assert.h>
 
 uint16_t write_raw_record(Page& page, const uint8_t* raw, uint16_t size) {
@@ -13,4 +14,123 @@ uint16_t write_raw_record(Page& page, const uint8_t* raw, uint16_t size) {
 
     ph->free_start += size;
     return offset;
-}
\ No newline at end of file
+}
+
+// size of the cell a slot points to, leaf records and internal entries have different headers
+uint16_t cell_size(Page& page, uint16_t slot_index) {
+    const uint8_t* cell = page.data + *slot_ptr(page, slot_index);
+    if (get_header(page)->page_level == PageLevel::INTERNAL) {
+        auto* entry = reinterpret_cast<const InternalEntry*>(cell);
+        return sizeof(InternalEntry) + entry->key_size;
+    }
+    auto* rh = reinterpret_cast<const RecordHeader*>(cell);
+    return record_size(rh->key_size, rh->value_size);
+}
+
+// Keep the first `keep` cells and rewrite them contiguously from the start of the page,
+// so the bytes of the dropped cells become free space again. A leaf also gets the longest
+// prefix the kept keys share.
+void truncate_page(Page& page, uint16_t keep) {
+    if (get_header(page)->page_level == PageLevel::LEAF) {
+        move_records(page, 0, keep, page);
+        return;
+    }
+
+    Page old_page;
+    memcpy(old_page.data, page.data, PAGE_SIZE);
+
+    auto* ph = get_header(page);
+    assert(keep <= ph->cell_count);
+    memset(page.data + sizeof(PageHeader), 0, PAGE_SIZE - sizeof(PageHeader));
+    ph->cell_count = 0;
+    ph->free_start = sizeof(PageHeader);
+    ph->free_end = PAGE_DATA_END;
+
+    for (uint16_t i = 0; i < keep; i++) {
+        uint16_t size = cell_size(old_page, i);
+        uint16_t offset = write_raw_record(page, old_page.data + *slot_ptr(old_page, i), size);
+        insert_slot(page, i, offset);
+    }
+}
+
+// bytes held by live cells, their slots and a leaf's key prefix, records dropped by page_delete
+// don't count
+uint16_t live_bytes(Page& page) {
+    uint32_t used = get_header(page)->prefix_size;
+    for (uint16_t i = 0; i < get_header(page)->cell_count; i++) {
+        used += cell_size(page, i) + sizeof(uint16_t);
+    }
+    return static_cast<uint16_t>(used);
+}
+
+// can_insert only sees the gap between free_start and free_end. When that is too small but the
+// dead bytes left by deletes would cover it, rewrite the live cells contiguously first.
+bool make_room(Page& page, uint16_t size) {
+    if (can_insert(page, size)) {
+        return true;
+    }
+    if (live_bytes(page) + size + sizeof(uint16_t) > PAGE_DATA_END - sizeof(PageHeader)) {
+        return false;
+    }
+    truncate_page(page, get_header(page)->cell_count);
+    return can_insert(page, size);
+}
+
+// A count midpoint can leave the pending cell without room once cells run to kilobytes, so
+// split where the bytes are most even with that cell counted on the side it goes to: the left
+// one when at <= the split point, since the separator is the cell at the split point.
+uint16_t split_point(Page& page, uint16_t at, uint16_t size) {
+    auto* ph = get_header(page);
+    bool internal = ph->page_level == PageLevel::INTERNAL;
+    const uint32_t capacity = PAGE_DATA_END - sizeof(PageHeader);
+    uint32_t total = live_bytes(page);
+    uint32_t pending = size + sizeof(uint16_t);
+
+    uint16_t best = ph->cell_count / 2;
+    uint32_t best_diff = UINT32_MAX;
+    uint32_t running = 0; // cells before m
+    for (uint16_t m = 1; m < ph->cell_count; m++) {
+        running += cell_size(page, m - 1) + sizeof(uint16_t);
+        uint32_t left = running;
+        // an internal page's separator moves up and is in neither half
+        uint32_t right = total - running - (internal ? cell_size(page, m) + sizeof(uint16_t) : 0);
+        (at <= m ? left : right) += pending;
+        if (left > capacity || right > capacity) {
+            continue;
+        }
+        uint32_t diff = left > right ? left - right : right - left;
+        if (diff < best_diff) {
+            best_diff = diff;
+            best = m;
+        }
+    }
+    return best;
+}
+
+void shortest_separator(const Key& last, const Key& first, std::vector<uint8_t>& separator) {
+    uint16_t len = 0;
+    while (len < last.size && len < first.size && last.data[len] == first.data[len]) {
+        len++;
+    }
+    // last < first, so first has a byte past the shared part: the one that makes it larger
+    assert(len < first.size);
+    separator.assign(first.data, first.data + len + 1);
+}
+
+uint32_t leaf_next(Page& page) {
+    uint32_t page_id;
+    memcpy(&page_id, get_header(page)->reserved, sizeof(page_id));
+    return page_id;
+}
+
+void set_leaf_next(Page& page, uint32_t page_id) {
+    memcpy(get_header(page)->reserved, &page_id, sizeof(page_id));
+}
+
+uint32_t leaf_prev(Page& page) {
+    return get_header(page)->root_page;
+}
+
+void set_leaf_prev(Page& page, uint32_t page_id) {
+    get_header(page)->root_page = page_id;
+}
@@ -3,46 +3,62 @@
 #include "storage/btree.hpp"
 #include "storage/table_handle.hpp"
 #include "storage/record.hpp"
+#include <cstring>
+#include <vector>
 #include <assert.h>
 
-uint32_t find_leaf_page(TableHandle& th, const Key& key, Page& out_page) {
+// Returns the leaf (pinned in the buffer pool, or mapped in MMAP_READ_ONLY mode),
+// or an invalid guard on a corrupt tree
+PageGuard find_leaf_page(TableHandle& th, const Key& key) {
+    std::vector<uint32_t> path;
+    return find_leaf_page(th, key, path);
+}
+
+// Same, and path gets the internal pages passed on the way down, root first. Splits walk back
+// up it, pages don't store their parent.
+PageGuard find_leaf_page(TableHandle& th, const Key& key, std::vector<uint32_t>& path) {
+    path.clear();
     uint32_t page_id = th.root_page;
     int depth = 0;
     
     while(1) {
-        th.dm.read_page(page_id, out_page.data);
+        // reassigning the guard unpins the parent before descending
+        PageGuard guard = fetch_read_page(th, page_id);
+        if (!guard.valid()) {
+            return PageGuard();
+        }
         
-        auto* ph = get_header(out_page);
+        auto* ph = get_header(guard.page());
         
         if (ph->page_level == PageLevel::LEAF) {
-            return page_id;
+            return guard;
         }
         
-        uint32_t next_page_id = internal_find_child(out_page, key);
+        path.push_back(page_id);
+        uint32_t next_page_id = internal_find_child(guard.page(), key);
         
-        if (next_page_id == 0 || next_page_id >= 1000000) {
-            return UINT32_MAX;
+        if (next_page_id == 0 || next_page_id == INVALID_PAGE_ID) {
+            return PageGuard();
         }
         
         page_id = next_page_id;
         depth++;
         
         if (depth > 100) {
-            return UINT32_MAX;
+            return PageGuard();
         }
     }
 
-    return UINT32_MAX; // for any error
+    return PageGuard(); // for any error
 }
 
 
-bool btree_insert_leaf_no_split(TableHandle& th, uint32_t page_id, Page& page, const Key& key, const Value& value) {
-    uint16_t rec_size = record_size(key.size, value.size);
-    if (!can_insert(page, rec_size)) {
+bool btree_insert_leaf_no_split(PageGuard& leaf, const Key& key, const Value& value, uint8_t flags) {
+    Page& page = leaf.page();
+    // compacts the page or shortens its prefix when that makes the record fit
+    if (!page_insert(page, key.data, key.size, value.data, value.size, flags)) {
         return false;
     }
-
-    page_insert(page, key.data, key.size, value.data, value.size);
     
     // Validate page header before writing
     auto* ph_after = get_header(page);
@@ -53,12 +69,74 @@ bool btree_insert_leaf_no_split(TableHandle& th, uint32_t page_id, Page& page, c
         return false;
     }
 
-    th.dm.write_page(page_id, page.data);
+    leaf.mark_dirty();
     return true;
 }
 
 
-SplitLeafResult split_leaf_page(TableHandle& th, Page& page) {
+namespace {
+
+Key as_key(const std::vector<uint8_t>& key) {
+    return {key.data(), static_cast<uint16_t>(key.size())};
+}
+
+uint16_t common_prefix(const Key& first, const Key& second) {
+    uint16_t len = 0;
+    while (len < first.size && len < second.size && first.data[len] == second.data[len]) {
+        len++;
+    }
+    return len;
+}
+
+// split_point for a leaf, with each half counted under the prefix its keys (the pending one
+// included) will share. size is the pending record's size without a prefix.
+uint16_t leaf_split_point(Page& page, const Key& key, uint16_t size) {
+    const uint32_t capacity = PAGE_DATA_END - sizeof(PageHeader);
+    uint16_t n = get_header(page)->cell_count;
+    uint16_t at = search_record(page, key.data, key.size).index;
+
+    // full keys, and the running size of the records before each one without a prefix
+    std::vector<std::vector<uint8_t>> keys(n);
+    std::vector<uint32_t> before(n + 1, 0);
+    uint16_t prefix_len;
+    page_prefix(page, prefix_len);
+    for (uint16_t i = 0; i < n; i++) {
+        slot_key(page, i, keys[i]);
+        before[i + 1] = before[i] + cell_size(page, i) + prefix_len + sizeof(uint16_t);
+    }
+    uint32_t pending = size + sizeof(uint16_t);
+
+    uint16_t best = n / 2;
+    uint32_t best_diff = UINT32_MAX;
+    for (uint16_t m = 1; m < n; m++) {
+        // the pending record goes left when at <= m, the separator is keys[m]
+        bool left_gets = at <= m;
+        Key left_first = left_gets && at == 0 ? key : as_key(keys[0]);
+        Key left_last = left_gets && at == m ? key : as_key(keys[m - 1]);
+        Key right_last = !left_gets && at == n ? key : as_key(keys[n - 1]);
+        uint32_t left_prefix = common_prefix(left_first, left_last);
+        uint32_t right_prefix = common_prefix(as_key(keys[m]), right_last);
+
+        // a half stores its prefix once instead of in every record
+        uint32_t left = before[m] + (left_gets ? pending : 0);
+        uint32_t right = before[n] - before[m] + (left_gets ? 0 : pending);
+        left -= (m + (left_gets ? 1 : 0) - 1) * left_prefix;
+        right -= (n - m + (left_gets ? 0 : 1) - 1) * right_prefix;
+        if (left > capacity || right > capacity) {
+            continue;
+        }
+        uint32_t diff = left > right ? left - right : right - left;
+        if (diff < best_diff) {
+            best_diff = diff;
+            best = m;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+SplitLeafResult split_leaf_page(TableHandle& th, Page& page, const Key& key, uint16_t size) {
     PageHeader* ph = get_header(page);
     assert(ph->page_level == PageLevel::LEAF);
     
@@ -67,84 +145,70 @@ SplitLeafResult split_leaf_page(TableHandle& th, Page& page) {
         ph->free_end < sizeof(PageHeader) || ph->free_end > PAGE_SIZE ||
         ph->free_start > ph->free_end) {
         assert(false && "Cannot split corrupted page");
-        return {0, {nullptr, 0}};
+        return {};
+    }
+
+    uint16_t total = ph->cell_count;
+    if (total < 2) {
+        assert(false && "Cannot split page with less than 2 elements");
+        return {};
     }
 
-    uint32_t new_page_id = allocate_page(th);
+    uint32_t new_page_id = allocate_page(th, PageLevel::LEAF, ph->page_id);
 
-    Page new_page;
+    PageGuard new_guard = th.bpm.new_page_guard(new_page_id);
+    Page& new_page = new_guard.page();
     init_page(new_page, new_page_id, PageType::DATA, PageLevel::LEAF);
-    
-    // Set parent page ID for the new page
     PageHeader* new_ph = get_header(new_page);
-    new_ph->parent_page_id = ph->parent_page_id;
 
-    uint16_t total = ph->cell_count;
-    
-    if (total < 2) {
-        assert(false && "Cannot split page with less than 2 elements");
-        return {0, {nullptr, 0}};
+    // link the new page in right after the page being split
+    uint32_t old_next = leaf_next(page);
+    set_leaf_next(new_page, old_next);
+    set_leaf_prev(new_page, ph->page_id);
+    set_leaf_next(page, new_page_id);
+    if (old_next != 0) {
+        PageGuard next_guard = th.bpm.fetch_page_guard(old_next);
+        set_leaf_prev(next_guard.page(), new_page_id);
+        next_guard.mark_dirty();
     }
-    uint16_t split_index = total / 2;
+
+    uint16_t split_index = leaf_split_point(page, key, size);
     // Ensure at least one element stays in left page
     if (split_index == 0) {
         split_index = 1;
     }
 
-    // Copy records from split_index to end to new page
-    for(uint16_t i = split_index; i < total; i++) {
-        uint16_t offset = *slot_ptr(page, i);
-
-        auto* rh = reinterpret_cast<RecordHeader*>(page.data + offset);
-        auto rec_size = record_size(rh->key_size, rh->value_size);
+    // Copy records from split_index to end to new page, under the prefix they share
+    move_records(page, split_index, total, new_page);
 
-        uint8_t buffer[PAGE_SIZE];
-        memcpy(buffer, page.data + offset, rec_size);
+    // Drop the moved records from the left page and reclaim their bytes,
+    // otherwise the left page stays "full" and the next insert into it fails
+    truncate_page(page, split_index);
 
-        uint16_t new_offset = write_raw_record(new_page, buffer, rec_size);
-        insert_slot(new_page, get_header(new_page)->cell_count, new_offset);
-    }
-
-    // Remove slots from the end, working backwards
-    // Note: cell_count decreases as we remove, so we need to be careful
-    // We remove from total-1 down to split_index
-    uint16_t num_to_remove = total - split_index;
-    for(uint16_t j = 0; j < num_to_remove; j++) {
-        // Always remove the last slot (which shifts indices)
-        uint16_t last_index = get_header(page)->cell_count - 1;
-        if (last_index >= split_index) {
-            remove_slot(page, last_index);
-        } else {
-            break; // Shouldn't happen, but safety check
-        }
-    }
-
-    uint16_t sep_len;
-    const uint8_t* sep_data;
-    
-    // Get separator key from the new page (first key in right page)
+    // The separator only has to tell the left page's last key from the right page's first, so
+    // the parent gets the shortest key that does. The pending key counts as the left page's last
+    // when it goes there (it sorts before the right page's first, see leaf_split_point).
     // If new page is empty (can happen with single large record), use first key from left page
+    SplitLeafResult result;
+    result.new_page = new_page_id;
     if (new_ph->cell_count > 0) {
-        sep_data = slot_key(new_page, 0, sep_len);
+        std::vector<uint8_t> left_last, right_first;
+        slot_key(page, split_index - 1, left_last);
+        slot_key(new_page, 0, right_first);
+        Key last = as_key(left_last);
+        if (compare_keys(key.data, key.size, right_first.data(), static_cast<uint16_t>(right_first.size())) < 0 &&
+            compare_keys(key.data, key.size, last.data, last.size) > 0) {
+            last = key;
+        }
+        shortest_separator(last, as_key(right_first), result.key_buf);
     } else {
         // New page is empty, use first key from left page as separator
         // This happens when splitting a single large record
-        sep_data = slot_key(page, 0, sep_len);
-    }
-
-    // Copy the separator key data before writing the page (to avoid invalid pointer)
-    uint8_t sep_buf[256]; // Max key size
-    if (sep_len > 256) {
-        assert(false && "Key too large");
-        return {0, {nullptr, 0}};
+        slot_key(page, 0, result.key_buf);
     }
-    memcpy(sep_buf, sep_data, sep_len);
-    Key sep_key {sep_buf, sep_len};
+    result.seperator_key = {result.key_buf.data(), static_cast<uint16_t>(result.key_buf.size())};
 
-    th.dm.write_page(new_page_id, new_page.data);
+    new_guard.mark_dirty();
 
-    return {
-        new_page_id,
-        sep_key
-    };
+    return result;
 }
\ No newline at end of file
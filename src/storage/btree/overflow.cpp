@@ -0,0 +1,122 @@
+#include <cstdint>
+#include "storage/page.hpp"
+#include "storage/btree.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/record.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// A value longer than MAX_INLINE_VALUE is stored as a stub in the leaf (its first
+// OVERFLOW_PREFIX bytes and an OverflowRef) and the rest in a chain of OVERFLOW pages, each
+// holding the next chunk right after its header and the next page id in reserved.
+
+namespace {
+
+uint32_t overflow_next(Page& page) {
+    uint32_t next;
+    memcpy(&next, get_header(page)->reserved, sizeof(next));
+    return next;
+}
+
+bool overflow_ref(Page& leaf, uint16_t index, OverflowRef& ref) {
+    auto* rh = reinterpret_cast<const RecordHeader*>(leaf.data + *slot_ptr(leaf, index));
+    if (!(rh->flags & RECORD_OVERFLOW)) {
+        return false;
+    }
+    uint16_t stub_len;
+    const uint8_t* stub = slot_value(leaf, index, stub_len);
+    memcpy(&ref, stub + OVERFLOW_PREFIX, sizeof(ref));
+    return true;
+}
+
+void free_chain(TableHandle& th, const OverflowRef& ref) {
+    uint32_t page_id = ref.first_page;
+    for (uint32_t i = overflow_page_count(ref.length); i > 0 && page_id != 0; i--) {
+        PageGuard guard = th.bpm.fetch_page_guard(page_id);
+        uint32_t next = overflow_next(guard.page());
+        init_page(guard.page(), page_id, PageType::FREE, PageLevel::NONE);
+        guard.mark_dirty();
+        free_page(th, page_id);
+        page_id = next;
+    }
+}
+
+} // namespace
+
+uint32_t overflow_page_count(uint32_t value_size) {
+    return (value_size - OVERFLOW_PREFIX + OVERFLOW_CHUNK - 1) / OVERFLOW_CHUNK;
+}
+
+void init_overflow_page(Page& page, uint32_t page_id, uint32_t next, const Value& value, uint32_t chunk) {
+    init_page(page, page_id, PageType::OVERFLOW, PageLevel::NONE);
+    auto* ph = get_header(page);
+    memcpy(ph->reserved, &next, sizeof(next));
+
+    uint32_t offset = OVERFLOW_PREFIX + chunk * OVERFLOW_CHUNK;
+    uint32_t len = std::min<uint32_t>(OVERFLOW_CHUNK, value.size - offset);
+    memcpy(page.data + sizeof(PageHeader), value.data + offset, len);
+    ph->free_start = static_cast<uint16_t>(sizeof(PageHeader) + len);
+}
+
+Value overflow_stub(const Value& value, uint32_t first_page, std::vector<uint8_t>& buf) {
+    OverflowRef ref{first_page, value.size};
+    buf.assign(value.data, value.data + OVERFLOW_PREFIX);
+    buf.resize(OVERFLOW_PREFIX + sizeof(ref));
+    memcpy(buf.data() + OVERFLOW_PREFIX, &ref, sizeof(ref));
+    return {buf.data(), static_cast<uint16_t>(buf.size())};
+}
+
+Value spill_value(TableHandle& th, const Value& value, std::vector<uint8_t>& buf) {
+    // the chain gets its own extent, so it reads back sequentially and leaves the leaf runs alone
+    std::vector<uint32_t> pages(overflow_page_count(value.size));
+    uint32_t near = INVALID_PAGE_ID;
+    for (uint32_t& page_id : pages) {
+        page_id = allocate_page(th, PageLevel::NONE, near);
+        near = page_id;
+    }
+    for (uint32_t i = 0; i < pages.size(); i++) {
+        PageGuard guard = th.bpm.new_page_guard(pages[i]);
+        init_overflow_page(guard.page(), pages[i], i + 1 < pages.size() ? pages[i + 1] : 0, value, i);
+        guard.mark_dirty();
+    }
+    return overflow_stub(value, pages[0], buf);
+}
+
+Value record_value(TableHandle& th, Page& leaf, uint16_t index, std::vector<uint8_t>& buf) {
+    uint16_t value_len;
+    const uint8_t* value_data = slot_value(leaf, index, value_len);
+    OverflowRef ref;
+    if (!overflow_ref(leaf, index, ref)) {
+        return {value_data, value_len};
+    }
+
+    buf.resize(ref.length);
+    memcpy(buf.data(), value_data, OVERFLOW_PREFIX);
+    uint32_t copied = OVERFLOW_PREFIX;
+    uint32_t page_id = ref.first_page;
+    while (copied < ref.length) {
+        PageGuard guard = fetch_read_page(th, page_id);
+        if (!guard.valid() || get_header(guard.page())->page_type != PageType::OVERFLOW) {
+            return {nullptr, 0}; // broken chain
+        }
+        uint32_t len = std::min<uint32_t>(OVERFLOW_CHUNK, ref.length - copied);
+        memcpy(buf.data() + copied, guard.page().data + sizeof(PageHeader), len);
+        copied += len;
+        page_id = overflow_next(guard.page());
+    }
+    return {buf.data(), static_cast<uint16_t>(ref.length)};
+}
+
+void free_overflow(TableHandle& th, Page& leaf, uint16_t index) {
+    OverflowRef ref;
+    if (overflow_ref(leaf, index, ref)) {
+        free_chain(th, ref);
+    }
+}
+
+void free_overflow(TableHandle& th, const Value& stub) {
+    OverflowRef ref;
+    memcpy(&ref, stub.data + OVERFLOW_PREFIX, sizeof(ref));
+    free_chain(th, ref);
+}
@@ -0,0 +1,362 @@
+#include "storage/buffer_pool.hpp"
+#include "storage/disk_manager.hpp"
+#include "storage/async_disk_manager.hpp"
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+// ---------------- LRUReplacer ----------------
+
+LRUReplacer::LRUReplacer(size_t num_frames)
+    : positions(num_frames), in_list(num_frames, false) {}
+
+void LRUReplacer::unpin(frame_id_t frame_id) {
+    if (in_list[frame_id]) {
+        return;
+    }
+    lru_list.push_front(frame_id);
+    positions[frame_id] = lru_list.begin();
+    in_list[frame_id] = true;
+}
+
+void LRUReplacer::pin(frame_id_t frame_id) {
+    if (!in_list[frame_id]) {
+        return;
+    }
+    lru_list.erase(positions[frame_id]);
+    in_list[frame_id] = false;
+}
+
+bool LRUReplacer::victim(frame_id_t& frame_id) {
+    if (lru_list.empty()) {
+        return false;
+    }
+    frame_id = lru_list.back();
+    lru_list.pop_back();
+    in_list[frame_id] = false;
+    return true;
+}
+
+size_t LRUReplacer::size() const {
+    return lru_list.size();
+}
+
+// ---------------- ClockReplacer ----------------
+
+ClockReplacer::ClockReplacer(size_t num_frames)
+    : evictable(num_frames, false), ref_bit(num_frames, false) {}
+
+void ClockReplacer::unpin(frame_id_t frame_id) {
+    if (!evictable[frame_id]) {
+        evictable[frame_id] = true;
+        count++;
+    }
+    ref_bit[frame_id] = true;
+}
+
+void ClockReplacer::pin(frame_id_t frame_id) {
+    if (evictable[frame_id]) {
+        evictable[frame_id] = false;
+        count--;
+    }
+}
+
+bool ClockReplacer::victim(frame_id_t& frame_id) {
+    if (count == 0) {
+        return false;
+    }
+    // at most two sweeps: first clears reference bits, second must find one
+    while (true) {
+        if (evictable[hand]) {
+            if (ref_bit[hand]) {
+                ref_bit[hand] = false;
+            } else {
+                frame_id = static_cast<frame_id_t>(hand);
+                evictable[hand] = false;
+                count--;
+                hand = (hand + 1) % evictable.size();
+                return true;
+            }
+        }
+        hand = (hand + 1) % evictable.size();
+    }
+}
+
+size_t ClockReplacer::size() const {
+    return count;
+}
+
+// ---------------- BufferPoolManager ----------------
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager* disk_manager,
+                                     std::unique_ptr<Replacer> policy)
+    : page_memory(pool_size),
+      frames(pool_size),
+      replacer(policy ? std::move(policy) : std::make_unique<LRUReplacer>(pool_size)),
+      disk_manager(disk_manager)
+{
+    page_table.reserve(pool_size);
+    for (size_t i = 0; i < pool_size; i++) {
+        frames[i].page = &page_memory[i];
+        free_list.push_back(static_cast<frame_id_t>(i));
+    }
+}
+
+BufferPoolManager::~BufferPoolManager() {
+    try {
+        flush_all_pages();
+    }
+    catch (const std::exception&) {
+        // nothing sensible to do with a write error during teardown
+    }
+}
+
+void BufferPoolManager::flush_frame(Frame& frame) {
+    if (frame.is_dirty) {
+        disk_manager->write_page(frame.page_id, frame.page->data);
+        frame.is_dirty = false;
+    }
+}
+
+// Take a frame from the free list, otherwise evict a victim (writing it back if dirty)
+bool BufferPoolManager::get_free_frame(frame_id_t& frame_id) {
+    if (!free_list.empty()) {
+        frame_id = free_list.front();
+        free_list.pop_front();
+        return true;
+    }
+
+    if (!replacer->victim(frame_id)) {
+        return false;
+    }
+
+    Frame& victim = frames[frame_id];
+    try {
+        flush_frame(victim);
+    } catch (...) {
+        replacer->unpin(frame_id); // still cached and dirty, keep it evictable
+        throw;
+    }
+    page_table.erase(victim.page_id);
+    victim.page_id = INVALID_PAGE_ID;
+    return true;
+}
+
+Page* BufferPoolManager::fetch_page(uint32_t page_id) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    auto it = page_table.find(page_id);
+    if (it != page_table.end()) {
+        Frame& frame = frames[it->second];
+        if (frame.pin_count++ == 0) {
+            replacer->pin(it->second);
+        }
+        hit_count++;
+        return frame.page;
+    }
+
+    frame_id_t frame_id;
+    if (!get_free_frame(frame_id)) {
+        throw std::runtime_error("Buffer pool exhausted: all frames are pinned");
+    }
+
+    Frame& frame = frames[frame_id];
+    try {
+        disk_manager->read_page(page_id, frame.page->data);
+    }
+    catch (...) {
+        free_list.push_back(frame_id);
+        throw;
+    }
+    frame.page_id = page_id;
+    frame.pin_count = 1;
+    frame.is_dirty = false;
+    page_table[page_id] = frame_id;
+    miss_count++;
+    return frame.page;
+}
+
+Page* BufferPoolManager::new_page(uint32_t page_id) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    frame_id_t frame_id;
+    auto it = page_table.find(page_id);
+    if (it != page_table.end()) {
+        // stale copy of a previously freed page, reuse its frame. Zeroing a page someone still
+        // holds would wipe it under them.
+        frame_id = it->second;
+        if (frames[frame_id].pin_count != 0) {
+            throw std::runtime_error("new_page: page " + std::to_string(page_id) + " is still pinned");
+        }
+        frames[frame_id].pin_count = 1;
+        replacer->pin(frame_id);
+    } else {
+        if (!get_free_frame(frame_id)) {
+            throw std::runtime_error("Buffer pool exhausted: all frames are pinned");
+        }
+        frames[frame_id].pin_count = 1;
+        page_table[page_id] = frame_id;
+    }
+
+    Frame& frame = frames[frame_id];
+    std::memset(frame.page->data, 0, PAGE_SIZE);
+    frame.page_id = page_id;
+    frame.is_dirty = true;
+    return frame.page;
+}
+
+bool BufferPoolManager::unpin_page(uint32_t page_id, bool is_dirty) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    auto it = page_table.find(page_id);
+    if (it == page_table.end()) {
+        return false;
+    }
+
+    Frame& frame = frames[it->second];
+    if (frame.pin_count == 0) {
+        return false;
+    }
+
+    frame.is_dirty = frame.is_dirty || is_dirty;
+    if (--frame.pin_count == 0) {
+        replacer->unpin(it->second);
+    }
+    return true;
+}
+
+bool BufferPoolManager::flush_page(uint32_t page_id) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    auto it = page_table.find(page_id);
+    if (it == page_table.end()) {
+        return false;
+    }
+    flush_frame(frames[it->second]);
+    return true;
+}
+
+bool BufferPoolManager::discard_page(uint32_t page_id) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    auto it = page_table.find(page_id);
+    if (it == page_table.end()) {
+        return true;
+    }
+    Frame& frame = frames[it->second];
+    if (frame.pin_count != 0) {
+        return false;
+    }
+    replacer->pin(it->second); // takes it out of the evictable set
+    free_list.push_back(it->second);
+    frame.page_id = INVALID_PAGE_ID;
+    frame.is_dirty = false;
+    page_table.erase(it);
+    return true;
+}
+
+void BufferPoolManager::flush_all_pages() {
+    std::lock_guard<std::mutex> lock(latch);
+
+    // in page order so neighbouring pages coalesce into one vectored write
+    std::vector<Frame*> dirty;
+    for (auto& entry : page_table) {
+        if (frames[entry.second].is_dirty) {
+            dirty.push_back(&frames[entry.second]);
+        }
+    }
+    std::sort(dirty.begin(), dirty.end(), [](const Frame* a, const Frame* b) {
+        return a->page_id < b->page_id;
+    });
+
+    if (dirty.empty()) {
+        return;
+    }
+
+    // one batch for every dirty frame instead of a write syscall per page
+    if (!async_io) {
+        async_io = std::make_unique<AsyncDiskManager>(*disk_manager);
+    }
+    // shared with the callbacks: if wait_all throws, writes still in flight complete on a later call
+    auto failed = std::make_shared<bool>(false);
+    for (Frame* frame : dirty) {
+        async_io->write_page_async(frame->page_id, frame->page->data, [frame, failed](bool ok) {
+            if (ok) {
+                frame->is_dirty = false;
+            } else {
+                *failed = true;
+            }
+        });
+    }
+    async_io->wait_all();
+
+    if (*failed) {
+        throw std::runtime_error("Failed to write back dirty pages");
+    }
+}
+
+void BufferPoolManager::reset() {
+    std::lock_guard<std::mutex> lock(latch);
+
+    // check every pin before touching anything, so a refusal leaves the pool as it was
+    for (auto& entry : page_table) {
+        if (frames[entry.second].pin_count != 0) {
+            throw std::runtime_error("Cannot reset buffer pool while pages are pinned");
+        }
+    }
+    for (auto& entry : page_table) {
+        flush_frame(frames[entry.second]);
+    }
+    for (auto& entry : page_table) {
+        replacer->pin(entry.second);
+    }
+
+    page_table.clear();
+    free_list.clear();
+    for (size_t i = 0; i < frames.size(); i++) {
+        frames[i].page_id = INVALID_PAGE_ID;
+        frames[i].is_dirty = false;
+        free_list.push_back(static_cast<frame_id_t>(i));
+    }
+}
+
+PageGuard BufferPoolManager::fetch_page_guard(uint32_t page_id) {
+    return PageGuard(this, page_id, fetch_page(page_id));
+}
+
+PageGuard BufferPoolManager::new_page_guard(uint32_t page_id) {
+    return PageGuard(this, page_id, new_page(page_id));
+}
+
+// ---------------- PageGuard ----------------
+
+PageGuard::PageGuard(PageGuard&& other) noexcept
+    : bpm(other.bpm), pid(other.pid), frame_page(other.frame_page), dirty(other.dirty)
+{
+    other.bpm = nullptr;
+    other.frame_page = nullptr;
+    other.dirty = false;
+}
+
+PageGuard& PageGuard::operator=(PageGuard&& other) noexcept {
+    if (this == &other) return *this;
+    release();
+    bpm = other.bpm;
+    pid = other.pid;
+    frame_page = other.frame_page;
+    dirty = other.dirty;
+    other.bpm = nullptr;
+    other.frame_page = nullptr;
+    other.dirty = false;
+    return *this;
+}
+
+void PageGuard::release() {
+    if (bpm != nullptr && frame_page != nullptr) {
+        bpm->unpin_page(pid, dirty);
+    }
+    bpm = nullptr;
+    frame_page = nullptr;
+    dirty = false;
+}
@@ -1,33 +1,206 @@
 #include "storage/disk_manager.hpp"
 #include "common/constants.hpp"
+#include "common/trace.hpp"
 #include "storage/page.hpp"
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
 #include <stdexcept>
-#include <iostream>
 #include <cstring>
 #include <algorithm>
+#include <vector>
+#include <cerrno>
 #ifdef _WIN32
 #include <io.h>
+#include <windows.h>
+#endif
+
+namespace {
+
+// 64-bit byte offset of a page, page_id * PAGE_SIZE overflows 32 bits past 4 GB
+inline uint64_t page_offset(uint32_t page_id) {
+    return static_cast<uint64_t>(page_id) * PAGE_SIZE;
+}
+
+#ifdef _WIN32
+// MinGW has no pread/pwrite, positional I/O goes through an OVERLAPPED offset instead
+ssize_t pread_at(int fd, void* buf, size_t count, uint64_t offset) {
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    OVERLAPPED ov{};
+    ov.Offset = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD n = 0;
+    if (!ReadFile(handle, buf, static_cast<DWORD>(count), &n, &ov)) {
+        if (GetLastError() == ERROR_HANDLE_EOF) {
+            return 0;
+        }
+        errno = EIO; // never EINTR, callers retry on that
+        return -1;
+    }
+    return static_cast<ssize_t>(n);
+}
+
+ssize_t pwrite_at(int fd, const void* buf, size_t count, uint64_t offset) {
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    OVERLAPPED ov{};
+    ov.Offset = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD n = 0;
+    if (!WriteFile(handle, buf, static_cast<DWORD>(count), &n, &ov)) {
+        errno = EIO;
+        return -1;
+    }
+    return static_cast<ssize_t>(n);
+}
+
+int64_t file_size(int fd) {
+    return _lseeki64(fd, 0, SEEK_END);
+}
+
+// No block reservation through the CRT, setting the size still saves the per-write extend
+int preallocate(int fd, uint64_t offset, uint64_t length) {
+    int64_t current = file_size(fd);
+    if (current >= 0 && static_cast<uint64_t>(current) >= offset + length) {
+        return 0;
+    }
+    return _chsize_s(fd, static_cast<__int64>(offset + length));
+}
+
+// https://stackoverflow.com/a/68324129
+int sync_fd(int fd) {
+    return _commit(fd);
+}
+#else
+static_assert(sizeof(off_t) >= 8, "off_t must be 64-bit, build with _FILE_OFFSET_BITS=64");
+
+ssize_t pread_at(int fd, void* buf, size_t count, uint64_t offset) {
+    return ::pread(fd, buf, count, static_cast<off_t>(offset));
+}
+
+ssize_t pwrite_at(int fd, const void* buf, size_t count, uint64_t offset) {
+    return ::pwrite(fd, buf, count, static_cast<off_t>(offset));
+}
+
+int64_t file_size(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        return -1;
+    }
+    return static_cast<int64_t>(st.st_size);
+}
+
+// Reserve [offset, offset + length) on disk and extend the file over it.
+// Returns 0 or an errno value.
+int preallocate(int fd, uint64_t offset, uint64_t length) {
+#if defined(__linux__)
+    if (fallocate(fd, 0, static_cast<off_t>(offset), static_cast<off_t>(length)) == 0) {
+        return 0;
+    }
+    if (errno != EOPNOTSUPP && errno != ENOSYS) {
+        return errno;
+    }
+#elif !defined(__APPLE__)
+    int err = posix_fallocate(fd, static_cast<off_t>(offset), static_cast<off_t>(length));
+    if (err == 0) {
+        return 0;
+    }
+    if (err != EINVAL && err != EOPNOTSUPP) {
+        return err;
+    }
+#endif
+    // The filesystem cannot reserve blocks, growing the size still saves the per-write extend.
+    // Never shrink: the cached size may lag behind writes made outside write_page.
+    int64_t current = file_size(fd);
+    if (current < 0) {
+        return errno;
+    }
+    if (static_cast<uint64_t>(current) >= offset + length) {
+        return 0;
+    }
+    return ftruncate(fd, static_cast<off_t>(offset + length)) == 0 ? 0 : errno;
+}
+
+int sync_fd(int fd) {
+#ifdef __linux__
+    // data plus the size change, without forcing unrelated inode metadata (mtime)
+    return fdatasync(fd);
+#else
+    return fsync(fd);
+#endif
+}
 #endif
 
-DiskManager::DiskManager(const std::string& file_path) {
+inline bool is_aligned(const void* ptr) {
+    return reinterpret_cast<uintptr_t>(ptr) % PAGE_ALIGNMENT == 0;
+}
+
+// Switch an open descriptor to uncached I/O, returns false if the platform or filesystem
+// (tmpfs for one) does not support it. The descriptor stays usable either way.
+bool enable_direct_io(int& fd, const std::string& file_path, int access) {
+#if defined(__linux__) && defined(O_DIRECT)
+    // O_DIRECT cannot be toggled with fcntl on every kernel, reopen instead
+    int direct_fd = open(file_path.c_str(), access | O_DIRECT);
+    if (direct_fd < 0) {
+        return false;
+    }
+    close(fd);
+    fd = direct_fd;
+    return true;
+#elif defined(__APPLE__)
+    (void)file_path;
+    (void)access;
+    return fcntl(fd, F_NOCACHE, 1) == 0;
+#else
+    // Windows needs FILE_FLAG_NO_BUFFERING at CreateFile time, which _open cannot pass
+    (void)fd;
+    (void)file_path;
+    (void)access;
+    return false;
+#endif
+}
+
+} // namespace
+
+DiskManager::DiskManager(const std::string& file_path, const DiskManagerOptions& options)
+    : opts(options) {
     // 0644 is the permission setting for the created file
     // each number represents user, group, others 
     // Use O_BINARY on Windows to avoid text mode translation
+    // A read-only open must find the file, it never creates one
+    int access = opts.read_only ? O_RDONLY : O_RDWR;
+    int create = opts.read_only ? 0 : O_CREAT;
     #ifdef _WIN32
-    file_descriptor = open(file_path.c_str(), O_RDWR | O_CREAT | O_BINARY, 0644);
+    file_descriptor = open(file_path.c_str(), access | create | O_BINARY, 0644);
     #else
-    file_descriptor = open(file_path.c_str(), O_RDWR | O_CREAT, 0644);
+    file_descriptor = open(file_path.c_str(), access | create, 0644);
     #endif
 
     if (file_descriptor < 0) {
-        throw std::runtime_error("Failed to open or create file");
+        throw std::runtime_error(opts.read_only ? "Failed to open file" : "Failed to open or create file");
+    }
+
+    if (opts.direct_io) {
+        direct = enable_direct_io(file_descriptor, file_path, access);
     }
+
+    int64_t size = file_size(file_descriptor);
+    if (size < 0) {
+        throw std::runtime_error("Failed to get file size");
+    }
+    allocated_size = static_cast<uint64_t>(size);
 }
 
 DiskManager::DiskManager(DiskManager&& other) noexcept {
     file_descriptor = other.file_descriptor;
+    opts = other.opts;
+    direct = other.direct;
+    allocated_size = other.allocated_size;
+    unsynced_writes = other.unsynced_writes;
+    syncs = other.syncs;
+    last_sync = other.last_sync;
     other.file_descriptor = -1;
 }
 
@@ -37,6 +210,12 @@ DiskManager& DiskManager::operator=(DiskManager&& other) noexcept {
         close(file_descriptor);
     }
     file_descriptor = other.file_descriptor;
+    opts = other.opts;
+    direct = other.direct;
+    allocated_size = other.allocated_size;
+    unsynced_writes = other.unsynced_writes;
+    syncs = other.syncs;
+    last_sync = other.last_sync;
     other.file_descriptor = -1;
     return *this;
 }
@@ -47,19 +226,28 @@ DiskManager::~DiskManager() {
     }
 }
 
-void DiskManager::read_page(int page_id, uint8_t* page_data) {
-    long offset = static_cast<long>(page_id * PAGE_SIZE);
-    if (lseek(file_descriptor, offset, SEEK_SET) < 0) {
-        throw std::runtime_error("Failed to seek to the correct position for reading");
+void DiskManager::read_page(uint32_t page_id, uint8_t* page_data) {
+    if (direct && !is_aligned(page_data)) {
+        // direct I/O needs an aligned buffer, bounce through one
+        Page bounce;
+        read_page(page_id, bounce.data);
+        std::memcpy(page_data, bounce.data, PAGE_SIZE);
+        return;
     }
+
+    uint64_t offset = page_offset(page_id);
     
     // Read in a loop to ensure we get all bytes (in case of partial reads)
+    // Positional reads don't touch the shared file position, so readers don't race on it
     ssize_t total_read = 0;
     ssize_t bytes_read = 0;
     uint8_t* ptr = page_data;
     
     while (total_read < PAGE_SIZE) {
-        bytes_read = read(file_descriptor, ptr + total_read, PAGE_SIZE - total_read);
+        bytes_read = pread_at(file_descriptor, ptr + total_read, PAGE_SIZE - total_read, offset + total_read);
+        if (bytes_read < 0 && errno == EINTR) {
+            continue; // interrupted by a signal before reading anything
+        }
         if (bytes_read < 0) {
             throw std::runtime_error("Failed to read page data");
         }
@@ -70,59 +258,281 @@ void DiskManager::read_page(int page_id, uint8_t* page_data) {
         total_read += bytes_read;
     }
     
-    std::cout << "Read " << total_read << " bytes from page " << page_id << std::endl;
+    trace_io(IoOp::READ, page_id, static_cast<uint32_t>(total_read));
 
     if (total_read < PAGE_SIZE) {
         // Zero the rest if we didn't read the full page
         std::fill_n(page_data + total_read, PAGE_SIZE - total_read, 0);
     }
+
+    // a page past EOF was never written, anything else must carry a valid checksum
+    if (total_read > 0 && !verify_page_checksum(page_data)) {
+        throw std::runtime_error("Checksum mismatch on page " + std::to_string(page_id));
+    }
 }
 
-void DiskManager::write_page(int page_id, const void* page_data) {
-    long offset = static_cast<long>(page_id * PAGE_SIZE);
-    long required_size = offset + PAGE_SIZE;
-    
-    // Ensure file is large enough - seek to end and extend if needed
-    long current_size = lseek(file_descriptor, 0, SEEK_END);
-    if (current_size < 0) {
-        throw std::runtime_error("Failed to get file size");
+void DiskManager::write_page(uint32_t page_id, uint8_t* page_data) {
+    write_one(page_id, page_data);
+    write_completed();
+}
+
+// write_page without the sync policy, write_pages applies that once per batch
+void DiskManager::write_one(uint32_t page_id, uint8_t* page_data) {
+    check_writable();
+    if (direct && !is_aligned(page_data)) {
+        Page bounce;
+        std::memcpy(bounce.data, page_data, PAGE_SIZE);
+        write_one(page_id, bounce.data);
+        return;
     }
-    
-    if (current_size < required_size) {
-        // Extend file by writing a zero byte at the required position
-        if (lseek(file_descriptor, required_size - 1, SEEK_SET) < 0) {
-            throw std::runtime_error("Failed to seek to extend file");
-        }
-        char zero = 0;
-        ssize_t extend_bytes = write(file_descriptor, &zero, 1);
-        if (extend_bytes != 1) {
-            throw std::runtime_error("Failed to extend file");
-        }
-        // Flush after extending
-        _commit(file_descriptor);
+
+    uint64_t offset = page_offset(page_id);
+
+    stamp_page_checksum(page_data);
+
+    // The size is cached, growing only costs a syscall once per extent
+    if (offset + PAGE_SIZE > allocated_size) {
+        grow_file(offset);
     }
 
-    if (lseek(file_descriptor, offset, SEEK_SET) < 0) {
-        throw std::runtime_error("Failed to seek to the correct position for writing");
+    // Write in a loop, a positional write may be short just like a read
+    const uint8_t* ptr = page_data;
+    ssize_t bytes_written = 0;
+    while (bytes_written < PAGE_SIZE) {
+        ssize_t n = pwrite_at(file_descriptor, ptr + bytes_written, PAGE_SIZE - bytes_written, offset + bytes_written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        bytes_written += n;
     }
-    
-    ssize_t bytes_written = write(file_descriptor, page_data, PAGE_SIZE); 
 
-    std::cout << "Wrote " << bytes_written << " bytes to page " << page_id << std::endl;
+    trace_io(IoOp::WRITE, page_id, static_cast<uint32_t>(bytes_written));
 
     if (bytes_written != PAGE_SIZE) {
         throw std::runtime_error("Failed to write the complete page");
     }
-    
-    // Flush to ensure data is written to disk before next read
-    // On Windows, we need to use _commit instead of fsync
-    _commit(file_descriptor);
+}
+
+namespace {
+
+// Sorted copy of a batch. stable_sort keeps repeated writes of one page in submission order.
+std::vector<PageBuffer> sorted_by_page(const std::vector<PageBuffer>& pages) {
+    std::vector<PageBuffer> sorted = pages;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const PageBuffer& a, const PageBuffer& b) {
+        return a.page_id < b.page_id;
+    });
+    return sorted;
+}
+
+} // namespace
+
+// Length of the run of consecutive page ids starting at sorted[first], one vectored call each
+size_t DiskManager::run_length(const std::vector<PageBuffer>& sorted, size_t first) const {
+    size_t n = 1;
+    while (first + n < sorted.size() && n < MAX_IO_RUN &&
+           sorted[first + n].page_id == sorted[first + n - 1].page_id + 1 &&
+           (!direct || is_aligned(sorted[first + n].data))) {
+        n++;
+    }
+    // an unaligned buffer goes alone through the bounce path
+    if (direct && !is_aligned(sorted[first].data)) {
+        return 1;
+    }
+    return n;
+}
+
+void DiskManager::read_pages(const std::vector<PageBuffer>& pages) {
+    std::vector<PageBuffer> sorted = sorted_by_page(pages);
+    for (size_t i = 0; i < sorted.size();) {
+        size_t n = run_length(sorted, i);
+        if (n == 1) {
+            read_page(sorted[i].page_id, sorted[i].data);
+        } else {
+            read_run(&sorted[i], n);
+        }
+        i += n;
+    }
+}
+
+void DiskManager::write_pages(const std::vector<PageBuffer>& pages) {
+    if (pages.empty()) {
+        return;
+    }
+    check_writable();
+    std::vector<PageBuffer> sorted = sorted_by_page(pages);
+    for (size_t i = 0; i < sorted.size();) {
+        size_t n = run_length(sorted, i);
+        if (n == 1) {
+            write_one(sorted[i].page_id, sorted[i].data);
+        } else {
+            write_run(&sorted[i], n);
+        }
+        i += n;
+    }
+    // the whole batch counts as one write for the sync policy
+    write_completed();
+}
+
+#ifdef _WIN32
+
+// No preadv / pwritev in the CRT (ReadFileScatter needs unbuffered handles), go page by page
+void DiskManager::read_run(const PageBuffer* run, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        read_page(run[i].page_id, run[i].data);
+    }
+}
+
+void DiskManager::write_run(const PageBuffer* run, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        write_one(run[i].page_id, run[i].data);
+    }
+}
+
+#else
+
+void DiskManager::read_run(const PageBuffer* run, size_t count) {
+    std::vector<iovec> iov(count);
+    for (size_t i = 0; i < count; i++) {
+        iov[i].iov_base = run[i].data;
+        iov[i].iov_len = PAGE_SIZE;
+    }
+
+    ssize_t got;
+    do {
+        got = preadv(file_descriptor, iov.data(), static_cast<int>(count),
+                     static_cast<off_t>(page_offset(run[0].page_id)));
+    } while (got < 0 && errno == EINTR);
+    if (got < 0) {
+        throw std::runtime_error("Failed to read pages");
+    }
+
+    size_t complete = static_cast<size_t>(got) / PAGE_SIZE;
+    for (size_t i = 0; i < complete; i++) {
+        trace_io(IoOp::READ, run[i].page_id, PAGE_SIZE);
+        if (!verify_page_checksum(run[i].data)) {
+            throw std::runtime_error("Checksum mismatch on page " + std::to_string(run[i].page_id));
+        }
+    }
+    // short read: EOF or an interrupted call, the rest goes page by page (zero fill past EOF)
+    for (size_t i = complete; i < count; i++) {
+        read_page(run[i].page_id, run[i].data);
+    }
+}
+
+void DiskManager::write_run(const PageBuffer* run, size_t count) {
+    std::vector<iovec> iov(count);
+    for (size_t i = 0; i < count; i++) {
+        stamp_page_checksum(run[i].data);
+        iov[i].iov_base = run[i].data;
+        iov[i].iov_len = PAGE_SIZE;
+    }
+
+    // the run may cross extent boundaries, reserve every extent it touches
+    for (size_t i = 0; i < count; i++) {
+        uint64_t offset = page_offset(run[i].page_id);
+        if (offset + PAGE_SIZE > allocated_size) {
+            grow_file(offset);
+        }
+    }
+
+    ssize_t written;
+    do {
+        written = pwritev(file_descriptor, iov.data(), static_cast<int>(count),
+                          static_cast<off_t>(page_offset(run[0].page_id)));
+    } while (written < 0 && errno == EINTR);
+    if (written < 0) {
+        throw std::runtime_error("Failed to write pages");
+    }
+
+    size_t complete = static_cast<size_t>(written) / PAGE_SIZE;
+    for (size_t i = 0; i < complete; i++) {
+        trace_io(IoOp::WRITE, run[i].page_id, PAGE_SIZE);
+    }
+    for (size_t i = complete; i < count; i++) {
+        write_one(run[i].page_id, run[i].data);
+    }
+}
+
+#endif
+
+// Preallocate the whole extent holding the page at offset. Sequential growth gets contiguous
+// extents; a jump far past the end leaves a sparse hole instead of reserving everything up to it.
+void DiskManager::grow_file(uint64_t offset) {
+    uint64_t extent = static_cast<uint64_t>(std::max<uint32_t>(opts.extent_pages, 1)) * PAGE_SIZE;
+    uint64_t extent_start = offset / extent * extent;
+    uint64_t start = std::max(extent_start, allocated_size);
+    uint64_t end = extent_start + extent;
+
+    if (preallocate(file_descriptor, start, end - start) != 0) {
+        throw std::runtime_error("Failed to extend file");
+    }
+    allocated_size = end;
+}
+
+void DiskManager::check_writable() const {
+    if (opts.read_only) {
+        throw std::runtime_error("Cannot write to a file opened read-only");
+    }
+}
+
+void DiskManager::prepare_write(uint32_t page_id, uint8_t* page_data) {
+    check_writable();
+    stamp_page_checksum(page_data);
+    uint64_t offset = page_offset(page_id);
+    if (offset + PAGE_SIZE > allocated_size) {
+        grow_file(offset);
+    }
+}
+
+void DiskManager::write_completed() {
+    // Reads see the write through the OS cache either way, syncing is only about durability
+    unsynced_writes = true;
+    sync_after_write();
+}
+
+void DiskManager::sync_after_write() {
+    switch (opts.sync_policy) {
+        case SyncPolicy::EVERY_WRITE:
+            flush();
+            break;
+        case SyncPolicy::PERIODIC:
+            sync_if_due();
+            break;
+        case SyncPolicy::GROUP:
+        case SyncPolicy::NONE:
+            break;
+    }
+}
+
+bool DiskManager::sync_if_due() {
+    if (!unsynced_writes) {
+        return false;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_sync < std::chrono::milliseconds(opts.sync_interval_ms)) {
+        return false;
+    }
+    flush();
+    return true;
+}
+
+void DiskManager::set_sync_policy(SyncPolicy policy, uint32_t interval_ms) {
+    opts.sync_policy = policy;
+    opts.sync_interval_ms = interval_ms;
 }
 
 void DiskManager::flush() {
-    // https://stackoverflow.com/a/68324129
-    // TODO: Use fsync on Unixbased systems
-    if (_commit(file_descriptor) < 0) {
+    if (!unsynced_writes) {
+        return; // nothing written through this handle since the last barrier
+    }
+    if (sync_fd(file_descriptor) < 0) {
         throw std::runtime_error("Failed to flush data to disk");
     }
+    trace_io(IoOp::SYNC, INVALID_PAGE_ID, 0);
+    unsynced_writes = false;
+    last_sync = std::chrono::steady_clock::now();
+    syncs++;
 }
\ No newline at end of file
@@ -0,0 +1,382 @@
+#include "storage/free_space_map.hpp"
+#include "storage/buffer_pool.hpp"
+#include "storage/page.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Bitmap page layout: bytes after the header up to the trailer, bit b of byte i = page i * 8 + b.
+// Loaded as little-endian 64-bit words, so bit k of word w is page w * 64 + k.
+constexpr uint32_t META_PAGE = 0;
+constexpr uint32_t FIRST_BITMAP_PAGE = 1;
+constexpr size_t NO_LEVEL = static_cast<size_t>(-1);
+
+// Meta page body: the bitmap count followed by the summary words
+#pragma pack(push, 1)
+struct FreeSpaceHeader {
+    uint32_t bitmap_count; // 0 in tables created before the summary existed: one bitmap, page 1
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+constexpr size_t SUMMARY_OFFSET = sizeof(PageHeader) + sizeof(FreeSpaceHeader);
+constexpr size_t SUMMARY_WORDS = (PAGE_DATA_END - SUMMARY_OFFSET) / sizeof(uint64_t);
+
+// the summary has to fit in the meta page and every covered page id must stay below INVALID_PAGE_ID
+constexpr size_t MAX_BITMAPS = std::min<size_t>(SUMMARY_WORDS * 64,
+                                                 INVALID_PAGE_ID / FreeSpaceMap::PAGES_PER_BITMAP);
+
+inline int lowest_set_bit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+inline int bit_count(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    while (word) {
+        word &= word - 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+} // namespace
+
+uint32_t FreeSpaceMap::bitmap_page_id(size_t k) {
+    return k == 0 ? FIRST_BITMAP_PAGE : static_cast<uint32_t>(k * PAGES_PER_BITMAP);
+}
+
+void FreeSpaceMap::load(BufferPoolManager& bpm) {
+    clear();
+    pool = &bpm;
+
+    PageGuard meta = bpm.fetch_page_guard(META_PAGE);
+    FreeSpaceHeader header;
+    std::memcpy(&header, meta.page().data + sizeof(PageHeader), sizeof(header));
+
+    size_t count = std::max<size_t>(header.bitmap_count, 1);
+    bitmaps.resize(count);
+    full.assign(SUMMARY_WORDS, 0);
+    std::memcpy(full.data(), meta.page().data + SUMMARY_OFFSET, SUMMARY_WORDS * sizeof(uint64_t));
+    if (header.bitmap_count == 0) {
+        // legacy layout, nothing persisted yet
+        full[0] = 0;
+        summary_dirty = true;
+    }
+    // every table allocates from the first bitmap, the others wait until they are needed
+    bitmap(0);
+}
+
+void FreeSpaceMap::write_back(BufferPoolManager& bpm) {
+    if (!pending.empty()) {
+        apply_pending();
+    }
+    for (size_t k = 0; k < bitmaps.size(); k++) {
+        Bitmap& b = bitmaps[k];
+        if (!b.dirty) {
+            continue;
+        }
+        PageGuard page = bpm.fetch_page_guard(bitmap_page_id(k));
+        std::memcpy(page.page().data + sizeof(PageHeader), b.words.data(), BITMAP_WORDS * sizeof(uint64_t));
+        page.mark_dirty();
+        b.dirty = false;
+    }
+
+    if (summary_dirty) {
+        PageGuard meta = bpm.fetch_page_guard(META_PAGE);
+        FreeSpaceHeader header{static_cast<uint32_t>(bitmaps.size()), 0};
+        std::memcpy(meta.page().data + sizeof(PageHeader), &header, sizeof(header));
+        std::memcpy(meta.page().data + SUMMARY_OFFSET, full.data(), SUMMARY_WORDS * sizeof(uint64_t));
+        meta.mark_dirty();
+        summary_dirty = false;
+    }
+}
+
+void FreeSpaceMap::clear() {
+    pool = nullptr;
+    pending.clear();
+    bitmaps.clear();
+    full.clear();
+    hint = 0;
+    summary_dirty = false;
+    for (Extent& e : extents) {
+        e = Extent{};
+    }
+    extent_hint = 0;
+}
+
+FreeSpaceMap::Bitmap& FreeSpaceMap::bitmap(size_t k) {
+    Bitmap& b = bitmaps[k];
+    if (b.words.empty()) {
+        PageGuard page = pool->fetch_page_guard(bitmap_page_id(k));
+        b.words.assign(BITMAP_WORDS, 0);
+        std::memcpy(b.words.data(), page.page().data + sizeof(PageHeader), BITMAP_WORDS * sizeof(uint64_t));
+        // meta, first bitmap and the initial root / a bitmap's own page are never handed out
+        b.words[0] |= (k == 0) ? 0x7 : 0x1;
+    }
+    return b;
+}
+
+void FreeSpaceMap::set_full(size_t k, bool is_full) {
+    uint64_t mask = uint64_t(1) << (k % 64);
+    bool was_full = (full[k / 64] & mask) != 0;
+    if (was_full == is_full) {
+        return;
+    }
+    if (is_full) {
+        full[k / 64] |= mask;
+    } else {
+        full[k / 64] &= ~mask;
+    }
+    summary_dirty = true;
+}
+
+// Lowest free page of bitmap k, INVALID_PAGE_ID (and marked full) if there is none
+uint32_t FreeSpaceMap::allocate_in(size_t k) {
+    Bitmap& b = bitmap(k);
+    for (size_t w = b.hint; w < b.words.size(); w++) {
+        uint64_t free_bits = ~b.words[w];
+        if (free_bits == 0) {
+            continue;
+        }
+        uint32_t first = static_cast<uint32_t>(k * PAGES_PER_BITMAP + w * 64);
+        if (in_extent(first, first + 63, NO_LEVEL)) {
+            continue;
+        }
+        int bit = lowest_set_bit(free_bits);
+        b.words[w] |= uint64_t(1) << bit;
+        b.hint = w;
+        b.dirty = true;
+        return static_cast<uint32_t>(k * PAGES_PER_BITMAP + w * 64 + bit);
+    }
+    b.hint = b.words.size();
+    set_full(k, true);
+    return INVALID_PAGE_ID;
+}
+
+// The table outgrew its bitmaps, start the next one in the first page it covers
+void FreeSpaceMap::add_bitmap() {
+    size_t k = bitmaps.size();
+    uint32_t page_id = bitmap_page_id(k);
+
+    PageGuard page = pool->new_page_guard(page_id);
+    init_page(page.page(), page_id, PageType::META, PageLevel::NONE);
+    page.mark_dirty();
+
+    bitmaps.emplace_back();
+    Bitmap& b = bitmaps.back();
+    b.words.assign(BITMAP_WORDS, 0);
+    b.words[0] = 0x1; // the bitmap page itself
+    b.dirty = true;
+    summary_dirty = true;
+}
+
+uint32_t FreeSpaceMap::allocate() {
+    if (!pending.empty()) {
+        apply_pending();
+    }
+    while (true) {
+        // first bitmap at or after the hint whose full bit is clear
+        size_t k = bitmaps.size();
+        for (size_t w = hint / 64; w * 64 < bitmaps.size(); w++) {
+            uint64_t candidates = ~full[w];
+            if (w == hint / 64) {
+                candidates &= ~uint64_t(0) << (hint % 64);
+            }
+            if (candidates != 0) {
+                k = std::min(bitmaps.size(), w * 64 + lowest_set_bit(candidates));
+                break;
+            }
+        }
+
+        if (k == bitmaps.size()) {
+            if (bitmaps.size() >= MAX_BITMAPS) {
+                hint = k;
+                return INVALID_PAGE_ID;
+            }
+            add_bitmap();
+        }
+
+        hint = k;
+        uint32_t page_id = allocate_in(k);
+        if (page_id != INVALID_PAGE_ID) {
+            return page_id;
+        }
+        // bitmap k turned out full and is now marked so, try the next one
+    }
+}
+
+// Does [first, last] overlap the active extent of a level other than except
+bool FreeSpaceMap::in_extent(uint32_t first, uint32_t last, size_t except) const {
+    for (size_t level = 0; level < 3; level++) {
+        const Extent& e = extents[level];
+        if (level != except && e.next <= last && first < e.end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Mark page_id in use for level if it is free and not inside another level's extent
+bool FreeSpaceMap::take(uint32_t page_id, size_t level) {
+    size_t k = page_id / PAGES_PER_BITMAP;
+    if (k >= bitmaps.size() || in_extent(page_id, page_id, level)) {
+        return false;
+    }
+    Bitmap& b = bitmap(k);
+    size_t bit = page_id % PAGES_PER_BITMAP;
+    uint64_t mask = uint64_t(1) << (bit % 64);
+    if (b.words[bit / 64] & mask) {
+        return false;
+    }
+    b.words[bit / 64] |= mask;
+    b.dirty = true;
+    return true;
+}
+
+// First page of the lowest wholly free bitmap word nobody has reserved, adding a bitmap if
+// there is none. INVALID_PAGE_ID once the page id space is used up.
+uint32_t FreeSpaceMap::reserve_extent() {
+    for (size_t k = extent_hint / BITMAP_WORDS; k < bitmaps.size(); k++) {
+        Bitmap& b = bitmap(k);
+        size_t w = (k == extent_hint / BITMAP_WORDS) ? extent_hint % BITMAP_WORDS : 0;
+        for (; w < BITMAP_WORDS; w++) {
+            if (b.words[w] != 0) {
+                continue;
+            }
+            uint32_t first = static_cast<uint32_t>(k * PAGES_PER_BITMAP + w * 64);
+            if (in_extent(first, first + 63, NO_LEVEL)) {
+                continue;
+            }
+            extent_hint = k * BITMAP_WORDS + w;
+            return first;
+        }
+    }
+    extent_hint = bitmaps.size() * BITMAP_WORDS;
+
+    if (bitmaps.size() >= MAX_BITMAPS) {
+        return INVALID_PAGE_ID;
+    }
+    // word 0 holds the new bitmap's own page, the next one is free
+    add_bitmap();
+    return bitmap_page_id(bitmaps.size() - 1) + 64;
+}
+
+// Hand the unused rest of an extent back to plain allocate(), which skipped it
+void FreeSpaceMap::retire_extent(Extent& e) {
+    if (e.next < e.end) {
+        size_t k = e.next / PAGES_PER_BITMAP;
+        Bitmap& b = bitmap(k);
+        b.hint = std::min<size_t>(b.hint, (e.next % PAGES_PER_BITMAP) / 64);
+        set_full(k, false);
+        hint = std::min(hint, k);
+    }
+    e = Extent{};
+}
+
+uint32_t FreeSpaceMap::allocate(PageLevel level, uint32_t near) {
+    if (!pending.empty()) {
+        apply_pending();
+    }
+    size_t l = static_cast<size_t>(level);
+    Extent& e = extents[l];
+
+    if (near != INVALID_PAGE_ID && near + 1 != INVALID_PAGE_ID && take(near + 1, l)) {
+        return near + 1;
+    }
+    while (e.next < e.end) {
+        uint32_t page_id = e.next++;
+        if (take(page_id, l)) {
+            return page_id;
+        }
+    }
+
+    retire_extent(e);
+    uint32_t first = reserve_extent();
+    if (first == INVALID_PAGE_ID) {
+        return allocate();
+    }
+    e.next = first + 1;
+    e.end = first + EXTENT_PAGES;
+    take(first, l);
+    return first;
+}
+
+void FreeSpaceMap::release(uint32_t page_id) {
+    pending.push_back(page_id);
+}
+
+// Clear the queued pages in one pass: sorted, so each bitmap's hints and summary bit are
+// updated once however many of its pages were freed
+void FreeSpaceMap::apply_pending() {
+    std::sort(pending.begin(), pending.end());
+    pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+
+    size_t i = 0;
+    while (i < pending.size()) {
+        size_t k = pending[i] / PAGES_PER_BITMAP;
+        if (k >= bitmaps.size()) {
+            break; // sorted, everything after is out of range as well
+        }
+        Bitmap& b = bitmap(k);
+        size_t lowest_word = BITMAP_WORDS;
+        for (; i < pending.size() && pending[i] / PAGES_PER_BITMAP == k; i++) {
+            uint32_t page_id = pending[i];
+            if (page_id < 3 || page_id == bitmap_page_id(k)) {
+                continue;
+            }
+            size_t bit = page_id % PAGES_PER_BITMAP;
+            b.words[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+            lowest_word = std::min(lowest_word, bit / 64);
+            if (b.words[bit / 64] == 0) {
+                extent_hint = std::min(extent_hint, k * BITMAP_WORDS + bit / 64);
+            }
+        }
+        if (lowest_word == BITMAP_WORDS) {
+            continue;
+        }
+        b.hint = std::min(b.hint, lowest_word);
+        b.dirty = true;
+        set_full(k, false);
+        hint = std::min(hint, k);
+    }
+    pending.clear();
+}
+
+bool FreeSpaceMap::is_allocated(uint32_t page_id) {
+    if (!pending.empty()) {
+        apply_pending();
+    }
+    size_t k = page_id / PAGES_PER_BITMAP;
+    if (k >= bitmaps.size()) {
+        return false;
+    }
+    size_t bit = page_id % PAGES_PER_BITMAP;
+    return (bitmap(k).words[bit / 64] >> (bit % 64)) & 1;
+}
+
+uint32_t FreeSpaceMap::allocated_count() {
+    if (!pending.empty()) {
+        apply_pending();
+    }
+    uint32_t count = 0;
+    for (size_t k = 0; k < bitmaps.size(); k++) {
+        for (uint64_t word : bitmap(k).words) {
+            count += bit_count(word);
+        }
+    }
+    return count;
+}
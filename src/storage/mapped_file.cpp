@@ -0,0 +1,156 @@
+#include "storage/mapped_file.hpp"
+#include "common/constants.hpp"
+#include <memory>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : base(other.base), length(other.length), verified(std::move(other.verified)) {
+#ifdef _WIN32
+    mapping = other.mapping;
+    other.mapping = nullptr;
+#endif
+    other.base = nullptr;
+    other.length = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    base = other.base;
+    length = other.length;
+    verified = std::move(other.verified);
+#ifdef _WIN32
+    mapping = other.mapping;
+    other.mapping = nullptr;
+#endif
+    other.base = nullptr;
+    other.length = 0;
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& file_path) {
+    close();
+
+    HANDLE file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < PAGE_SIZE) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // the mapping object keeps the file open, the handle itself is no longer needed
+    HANDLE map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (map == nullptr) {
+        return false;
+    }
+
+    void* view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(map);
+        return false;
+    }
+
+    mapping = map;
+    base = static_cast<uint8_t*>(view);
+    length = static_cast<uint64_t>(size.QuadPart);
+    verified = std::make_unique<std::atomic<bool>[]>(page_count());
+    return true;
+}
+
+void MappedFile::close() {
+    if (base != nullptr) {
+        UnmapViewOfFile(base);
+        CloseHandle(static_cast<HANDLE>(mapping));
+    }
+    base = nullptr;
+    mapping = nullptr;
+    length = 0;
+    verified.reset();
+}
+
+#else
+
+bool MappedFile::open(const std::string& file_path) {
+    close();
+
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(PAGE_SIZE)) {
+        ::close(fd);
+        return false;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    // B+ tree lookups jump around the file, readahead would mostly fetch pages nobody asked for
+    madvise(addr, static_cast<size_t>(st.st_size), MADV_RANDOM);
+
+    base = static_cast<uint8_t*>(addr);
+    length = static_cast<uint64_t>(st.st_size);
+    verified = std::make_unique<std::atomic<bool>[]>(page_count());
+    return true;
+}
+
+void MappedFile::close() {
+    if (base != nullptr) {
+        munmap(base, static_cast<size_t>(length));
+    }
+    base = nullptr;
+    length = 0;
+    verified.reset();
+}
+
+#endif
+
+const Page* MappedFile::page(uint32_t page_id) const {
+    if (base == nullptr || page_id >= page_count()) {
+        return nullptr;
+    }
+    // the mapping starts on an OS page boundary, so pages keep their PAGE_ALIGNMENT
+    return reinterpret_cast<const Page*>(base + static_cast<uint64_t>(page_id) * PAGE_SIZE);
+}
+
+bool MappedFile::verify(uint32_t page_id) const {
+    const Page* mapped = page(page_id);
+    if (mapped == nullptr) {
+        return false;
+    }
+    if (verified[page_id].load(std::memory_order_relaxed)) {
+        return true;
+    }
+    // racing readers may both check the page, the outcome is the same
+    if (!verify_page_checksum(mapped->data)) {
+        return false;
+    }
+    verified[page_id].store(true, std::memory_order_relaxed);
+    return true;
+}
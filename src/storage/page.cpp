@@ -1,5 +1,6 @@
 #include "storage/page.hpp"
 #include "storage/record.hpp"
+#include "common/crc32c.hpp"
 #include <cstring>
 #include <algorithm>
 #include <stdexcept>
@@ -18,13 +19,34 @@ void init_page(Page& page, uint32_t page_id, PageType page_type, PageLevel page_
 
     std::fill_n(page_header->reserved, sizeof(page_header->reserved) / sizeof(page_header->reserved[0]), 0);
     
-    page_header->flags = 0;
+    page_header->prefix_size = 0;
     page_header->cell_count = 0;
     page_header->free_start = sizeof(PageHeader);
-    page_header->free_end = PAGE_SIZE;
+    page_header->free_end = PAGE_DATA_END;
     page_header->parent_page_id = 0;
     page_header->lsn = 0;
 }
 
+uint32_t page_checksum(const uint8_t* page_data) {
+    return crc32c(page_data, PAGE_DATA_END);
+}
 
+void stamp_page_checksum(uint8_t* page_data) {
+    uint32_t checksum = page_checksum(page_data);
+    std::memcpy(page_data + PAGE_DATA_END, &checksum, sizeof(checksum));
+}
 
+bool verify_page_checksum(const uint8_t* page_data) {
+    uint32_t stored;
+    std::memcpy(&stored, page_data + PAGE_DATA_END, sizeof(stored));
+    if (page_checksum(page_data) == stored) {
+        return true;
+    }
+    // slow path only on a mismatch: preallocated / sparse pages read back as zeroes
+    for (uint32_t i = 0; i < PAGE_SIZE; i++) {
+        if (page_data[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
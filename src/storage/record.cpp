@@ -2,6 +2,7 @@
 #include "storage/record.hpp"
 #include <cstring>
 #include <algorithm>
+#include <cassert>
 
 // helpers 
 bool can_insert(Page& page, uint16_t record_size) {
@@ -11,7 +12,7 @@ bool can_insert(Page& page, uint16_t record_size) {
 
 int compare_keys(const uint8_t* first, uint16_t first_size, const uint8_t* second, uint16_t second_size) {
     int min = std::min(first_size, second_size);
-    int res = std::memcmp(first, second, min);
+    int res = min > 0 ? std::memcmp(first, second, min) : 0; // empty keys may be null
 
     if (res != 0) return res;
 
@@ -19,22 +20,120 @@ int compare_keys(const uint8_t* first, uint16_t first_size, const uint8_t* secon
 }
 
 
-uint16_t write_record(Page& page, const uint8_t* key, uint16_t key_len, const uint8_t* value, uint16_t value_len) {
+static uint16_t common_prefix(const uint8_t* first, uint16_t first_size, const uint8_t* second, uint16_t second_size) {
+    uint16_t len = 0;
+    uint16_t max = std::min(first_size, second_size);
+    while (len < max && first[len] == second[len]) {
+        len++;
+    }
+    return len;
+}
+
+// Prefix, cells and slots of a leaf, dead bytes left by deletes excluded
+static uint32_t leaf_live_bytes(Page& page) {
+    PageHeader* page_header = get_header(page);
+    uint32_t live = page_header->prefix_size;
+    for (uint16_t i = 0; i < page_header->cell_count; i++) {
+        auto* rh = reinterpret_cast<const RecordHeader*>(page.data + *slot_ptr(page, i));
+        live += record_size(rh->key_size, rh->value_size) + sizeof(uint16_t);
+    }
+    return live;
+}
+
+// Full key of slot i into key, returns its length
+static uint16_t full_key(Page& page, uint16_t i, uint8_t* key) {
+    uint16_t prefix_len, suffix_len;
+    const uint8_t* prefix = page_prefix(page, prefix_len);
+    const uint8_t* suffix = slot_suffix(page, i, suffix_len);
+    std::memcpy(key, prefix, prefix_len);
+    std::memcpy(key + prefix_len, suffix, suffix_len);
+    return prefix_len + suffix_len;
+}
+
+// Append records [from, to) of src to dst, re-encoded under dst's prefix
+static void copy_records(Page& src, uint16_t from, uint16_t to, Page& dst) {
+    uint8_t key[PAGE_SIZE];
+    for (uint16_t i = from; i < to; i++) {
+        auto* rh = reinterpret_cast<const RecordHeader*>(src.data + *slot_ptr(src, i));
+        uint16_t key_len = full_key(src, i, key);
+        uint16_t value_len;
+        const uint8_t* value = slot_value(src, i, value_len);
+        uint16_t offset = write_record(dst, key, key_len, value, value_len, rh->flags & ~RECORD_DELETED);
+        insert_slot(dst, get_header(dst)->cell_count, offset);
+    }
+}
+
+void clear_leaf(Page& page, const uint8_t* prefix, uint16_t prefix_len) {
+    PageHeader* page_header = get_header(page);
+    std::memset(page.data + sizeof(PageHeader), 0, PAGE_SIZE - sizeof(PageHeader));
+    // prefix may be null for an empty page, memcpy must not see it then
+    if (prefix_len > 0) {
+        std::memcpy(page.data + sizeof(PageHeader), prefix, prefix_len);
+    }
+    page_header->prefix_size = prefix_len;
+    page_header->cell_count = 0;
+    page_header->free_start = sizeof(PageHeader) + prefix_len;
+    page_header->free_end = PAGE_DATA_END;
+}
+
+void move_records(Page& src, uint16_t from, uint16_t to, Page& dst) {
+    Page old;
+    std::memcpy(old.data, src.data, PAGE_SIZE);
+
+    // keys are sorted, so what the first and the last share every key in between shares too
+    uint8_t first[PAGE_SIZE];
+    uint16_t prefix_len = 0;
+    if (from < to) {
+        uint16_t first_len = full_key(old, from, first);
+        uint8_t last[PAGE_SIZE];
+        uint16_t last_len = full_key(old, to - 1, last);
+        prefix_len = common_prefix(first, first_len, last, last_len);
+    }
+    clear_leaf(dst, first, prefix_len);
+    copy_records(old, from, to, dst);
+}
+
+uint32_t leaf_bytes_with(Page& page, uint32_t live, const uint8_t* key, uint16_t key_len, uint16_t value_len) {
+    uint16_t count = get_header(page)->cell_count;
+    if (count == 0) {
+        // the key becomes the prefix
+        return key_len + record_size(0, value_len) + sizeof(uint16_t);
+    }
+    // every record takes back the part of the prefix the key doesn't share
+    uint16_t prefix_len;
+    const uint8_t* prefix = page_prefix(page, prefix_len);
+    uint16_t shared = common_prefix(prefix, prefix_len, key, key_len);
+    return live + (count - 1) * (prefix_len - shared) + record_size(key_len - shared, value_len) + sizeof(uint16_t);
+}
+
+uint16_t write_record(Page& page, const uint8_t* key, uint16_t key_len, const uint8_t* value, uint16_t value_len, uint8_t flags) {
     PageHeader* page_header = get_header(page);
 
+    // only the part after the page prefix is stored
+    uint16_t prefix_len = page_header->prefix_size;
+    assert(key_len >= prefix_len &&
+           (prefix_len == 0 || std::memcmp(key, page.data + sizeof(PageHeader), prefix_len) == 0));
+    key += prefix_len;
+    key_len -= prefix_len;
+
     uint16_t offset = page_header->free_start;
     uint8_t* ptr_to_write = page.data + offset;
 
     RecordHeader* record_header = reinterpret_cast<RecordHeader*>(ptr_to_write);
-    record_header->flags = 0;
+    record_header->flags = flags;
     record_header->key_size = key_len;
     record_header->value_size = value_len;
     ptr_to_write += sizeof(RecordHeader);
 
-    std::memcpy(ptr_to_write, key, key_len);
+    // an empty key or value may come with a null pointer (an empty vector's data())
+    if (key_len > 0) {
+        std::memcpy(ptr_to_write, key, key_len);
+    }
     ptr_to_write += key_len;
 
-    std::memcpy(ptr_to_write, value, value_len);
+    if (value_len > 0) {
+        std::memcpy(ptr_to_write, value, value_len);
+    }
     ptr_to_write += value_len;
 
     page_header->free_start = offset + record_size(key_len, value_len);
@@ -48,11 +147,27 @@ BSearchResult search_record(Page& page, const uint8_t* key, uint16_t key_len) {
     uint16_t left = 0;
     uint16_t right = header->cell_count;
 
+    // every key on the page starts with the prefix: a key that doesn't sorts before or after
+    // all of them, one that does is compared by what follows the prefix
+    uint16_t prefix_len;
+    const uint8_t* prefix = page_prefix(page, prefix_len);
+    if (right > 0 && prefix_len > 0) {
+        int cmp = key_len > 0 ? std::memcmp(key, prefix, std::min(key_len, prefix_len)) : -1;
+        if (cmp < 0 || (cmp == 0 && key_len < prefix_len)) {
+            return {false, 0};
+        }
+        if (cmp > 0) {
+            return {false, right};
+        }
+        key += prefix_len;
+        key_len -= prefix_len;
+    }
+
     while (left < right) {
         uint16_t mid = left + (right - left) / 2;
 
         uint16_t mid_key_len = 0;
-        const uint8_t* mid_key = slot_key(page, mid, mid_key_len);
+        const uint8_t* mid_key = slot_suffix(page, mid, mid_key_len);
 
         int cmp = compare_keys(mid_key, mid_key_len, key, key_len);
 
@@ -68,18 +183,30 @@ BSearchResult search_record(Page& page, const uint8_t* key, uint16_t key_len) {
 }
 
 
-bool page_insert(Page& page, const uint8_t* key, uint16_t key_size, const uint8_t* value, uint16_t value_size) {
+bool page_insert(Page& page, const uint8_t* key, uint16_t key_size, const uint8_t* value, uint16_t value_size, uint8_t flags) {
 
     BSearchResult result = search_record(page, key, key_size);
     if (result.found) {
         return false;
     }
       
-    uint16_t rsize = record_size(key_size, value_size);
-    if (!can_insert(page, rsize)) {
-        return false;
+    PageHeader* page_header = get_header(page);
+    uint16_t prefix_len;
+    const uint8_t* prefix = page_prefix(page, prefix_len);
+    uint16_t shared = page_header->cell_count == 0 ? key_size : common_prefix(prefix, prefix_len, key, key_size);
+
+    if (page_header->cell_count == 0 || shared != prefix_len ||
+        !can_insert(page, record_size(key_size - shared, value_size))) {
+        // rewrite the records under the shorter prefix, dropping dead bytes on the way
+        if (leaf_bytes_with(page, leaf_live_bytes(page), key, key_size, value_size) > PAGE_DATA_END - sizeof(PageHeader)) {
+            return false;
+        }
+        Page old;
+        std::memcpy(old.data, page.data, PAGE_SIZE);
+        clear_leaf(page, key, shared);
+        copy_records(old, 0, get_header(old)->cell_count, page);
     }
-    uint16_t roffset = write_record(page, key, key_size, value, value_size);
+    uint16_t roffset = write_record(page, key, key_size, value, value_size, flags);
 
     insert_slot(page, result.index, roffset);
     return true;
@@ -11,7 +11,12 @@ uint16_t* slot_ptr(Page& page, uint16_t index) {
     return reinterpret_cast<uint16_t*>(slot);
 }
 
-const uint8_t* slot_key(Page& page, uint16_t slot_index, uint16_t& key_len) {
+const uint8_t* page_prefix(Page& page, uint16_t& prefix_len) {
+    prefix_len = get_header(page)->prefix_size;
+    return page.data + sizeof(PageHeader);
+}
+
+const uint8_t* slot_suffix(Page& page, uint16_t slot_index, uint16_t& key_len) {
     PageHeader* header = get_header(page);
     
     // Validate slot_index
@@ -41,6 +46,18 @@ const uint8_t* slot_key(Page& page, uint16_t slot_index, uint16_t& key_len) {
     return page.data + record_offset + sizeof(RecordHeader);
 }
 
+void slot_key(Page& page, uint16_t slot_index, std::vector<uint8_t>& key) {
+    uint16_t prefix_len, suffix_len;
+    const uint8_t* prefix = page_prefix(page, prefix_len);
+    const uint8_t* suffix = slot_suffix(page, slot_index, suffix_len);
+    if (suffix == nullptr) {
+        key.clear();
+        return;
+    }
+    key.assign(prefix, prefix + prefix_len);
+    key.insert(key.end(), suffix, suffix + suffix_len);
+}
+
 const uint8_t* slot_value(Page& page, uint16_t slot_index, uint16_t& value_len) {
     uint16_t record_offset = *slot_ptr(page, slot_index);
     RecordHeader* record_header = reinterpret_cast<RecordHeader*>(page.data + record_offset);
@@ -90,9 +107,10 @@ void remove_slot(Page& page, uint16_t index) {
     uint16_t new_free_end = header->free_end;
 
     // shift slots before removed index to new positions
-    for(uint16_t i = 0; i < static_cast<int>(index); ++i) {
-        *reinterpret_cast<uint16_t*>(page.data + new_free_end + i * sizeof(uint16_t)) =
-            *reinterpret_cast<uint16_t*>(page.data + old_free_end + i * sizeof(uint16_t));
+    // the array moves up by one slot, so copy from the top down to avoid overwriting
+    for(uint16_t i = index; i > 0; --i) {
+        *reinterpret_cast<uint16_t*>(page.data + new_free_end + (i - 1) * sizeof(uint16_t)) =
+            *reinterpret_cast<uint16_t*>(page.data + old_free_end + (i - 1) * sizeof(uint16_t));
     }
     
     // shift slots after removed index to fill gap
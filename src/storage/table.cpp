@@ -2,12 +2,16 @@
 #include "storage/page.hpp"
 #include <sys/stat.h>
 #include <stdexcept>
+#ifdef _WIN32
 #include <direct.h> // _mkdir
+#else
+#define _mkdir(path) mkdir(path, 0755)
+#endif
 #include <cerrno>
 #include <assert.h>
 
 
-bool open_table(const std::string &name, TableHandle &th) {
+bool open_table(const std::string &name, TableHandle &th, TableOpenMode mode) {
     th.table_name = name;
     th.file_path = "data/" + name + ".db";
 
@@ -18,13 +22,29 @@ bool open_table(const std::string &name, TableHandle &th) {
 
     try {
         // TODO FIX 
-        th.dm = DiskManager(th.file_path);
+        // write back anything cached for the old file before swapping it out
+        th.fsm.write_back(th.bpm);
+        th.fsm.clear();
+        th.bpm.reset();
+        th.mapped.close();
+
+        // a read-only open must not need write access to the file, nor create it
+        th.dm = DiskManager(th.file_path, options_for(mode, th.dm.options()));
+
+        if (mode == TableOpenMode::MMAP_READ_ONLY) {
+            if (!th.mapped.open(th.file_path)) {
+                return false;
+            }
+            PageGuard meta = fetch_read_page(th, 0);
+            th.root_page = get_header(meta.page())->root_page;
+            return true;
+        }
 
-        Page meta;
-        th.dm.read_page(0, meta.data);
+        PageGuard meta = th.bpm.fetch_page_guard(0);
 
-        PageHeader *ph = get_header(meta);
+        PageHeader *ph = get_header(meta.page());
         th.root_page = ph->root_page;
+        th.fsm.load(th.bpm);
         return true;
     }
     catch (const std::exception &) {
@@ -76,55 +96,59 @@ bool create_table(const std::string &name) {
     }
 }
 
-// this one reserves a page id 
-uint32_t allocate_page(TableHandle &th) {
-    Page bitmap;
-    th.dm.read_page(1, bitmap.data);
-
-    uint8_t *bm = bitmap.data + sizeof(PageHeader);
-    uint32_t bitmap_size = PAGE_SIZE - sizeof(PageHeader);
-
-    // Scan bitmap byte by byte, bit by bit
-    for (uint32_t byte_idx = 0; byte_idx < bitmap_size; byte_idx++) {
-        uint8_t byte = bm[byte_idx];
-
-        // Check each bit in the byte
-        for (uint8_t bit_idx = 0; bit_idx < 8; bit_idx++) {
-            uint32_t page_id = byte_idx * 8 + bit_idx;
-
-            // Skip pages 0, 1, 2 (meta, bitmap, root)
-            if (page_id < 3) {
-                continue;
-            }
+// Durability barrier for a table: write back every dirty page in the pool, then sync the file.
+// With SyncPolicy::GROUP this is what a transaction / ingest batch calls once at the end.
+void flush_table(TableHandle &th) {
+    th.fsm.write_back(th.bpm);
+    th.bpm.flush_all_pages();
+    th.dm.flush();
+}
 
-            // Check if bit is free (0 = free, 1 = allocated)
-            if ((byte & (1 << bit_idx)) == 0) {
-                // Mark as allocated
-                bm[byte_idx] |= (1 << bit_idx);
-                th.dm.write_page(1, reinterpret_cast<const void *>(bitmap.data));
-                th.dm.flush();
-                return page_id;
-            }
+PageGuard fetch_read_page(TableHandle &th, uint32_t page_id) {
+    if (th.read_only()) {
+        const Page* page = th.mapped.page(page_id);
+        if (page == nullptr) {
+            return PageGuard();
+        }
+        if (!th.mapped.verify(page_id)) {
+            throw std::runtime_error("Checksum mismatch on page " + std::to_string(page_id));
         }
+        // no pool behind it, so the guard pins nothing. The mapping is PROT_READ,
+        // the const_cast only satisfies PageGuard and writes through it still fault.
+        return PageGuard(nullptr, page_id, const_cast<Page*>(page));
     }
-
-    // No free page found
-    return INVALID_PAGE_ID;
+    return th.bpm.fetch_page_guard(page_id);
 }
 
-void free_page(TableHandle &th, uint32_t page_id) {
-    Page bitmap;
-    th.dm.read_page(1, bitmap.data);
-
-    uint8_t *bm = bitmap.data + sizeof(PageHeader);
-
-    uint32_t bitmap_size = PAGE_SIZE - sizeof(PageHeader);
-    uint32_t byte_idx = page_id / 8;
-    uint32_t bit_idx = page_id % 8;
-    bm[byte_idx] &= ~(1 << bit_idx);
-    th.dm.write_page(1, reinterpret_cast<const void *>(bitmap.data));
-    th.dm.flush();
-    return;
+// this one reserves a page id 
+uint32_t allocate_page(TableHandle &th) {
+    if (th.read_only()) {
+        throw std::runtime_error("Cannot allocate pages in a read-only table");
+    }
+    if (!th.fsm.loaded()) {
+        th.fsm.load(th.bpm);
+    }
+    // served from the in-memory bitmap, the bitmap page is only rewritten on flush
+    return th.fsm.allocate();
 }
 
+uint32_t allocate_page(TableHandle &th, PageLevel level, uint32_t near) {
+    if (th.read_only()) {
+        throw std::runtime_error("Cannot allocate pages in a read-only table");
+    }
+    if (!th.fsm.loaded()) {
+        th.fsm.load(th.bpm);
+    }
+    return th.fsm.allocate(level, near);
+}
 
+void free_page(TableHandle &th, uint32_t page_id) {
+    if (th.read_only()) {
+        throw std::runtime_error("Cannot free pages in a read-only table");
+    }
+    if (!th.fsm.loaded()) {
+        th.fsm.load(th.bpm);
+    }
+    // queued in memory, applied with the other frees and persisted by flush_table
+    th.fsm.release(page_id);
+}
@@ -4,6 +4,7 @@
 #include "storage/record.hpp"
 #include "storage/table_handle.hpp"
 #include <assert.h>
+#include <vector>
 
 void test_table_and_page_allocator() {
     std::cout << "=== Storage Engine Core Test ===\n";
@@ -57,11 +58,195 @@ void test_table_and_page_allocator() {
     std::cout << "\n=== ALL STORAGE TESTS PASSED ===\n";
 }
 
+void test_cached_bitmap() {
+    std::cout << "\n=== Cached Allocation Bitmap Test ===\n";
+
+    const std::string table = "test_alloc_bitmap";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+
+    std::vector<uint32_t> freed;
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "open_table failed");
+
+        // allocation never goes back to the pool or the disk for the bitmap
+        uint64_t hits = th.bpm.hits(), misses = th.bpm.misses();
+        for (uint32_t i = 0; i < 5000; i++) {
+            uint32_t pid = allocate_page(th);
+            assert(pid == 3 + i && "Pages should come out in order");
+        }
+        assert(th.bpm.hits() == hits && th.bpm.misses() == misses && "Allocation touched the bitmap page");
+        std::cout << "[OK] 5000 allocations served from memory\n";
+
+        // freed pages come back lowest first
+        free_page(th, 4000);
+        free_page(th, 100);
+        assert(allocate_page(th) == 100);
+        assert(allocate_page(th) == 4000);
+        assert(allocate_page(th) == 5003);
+        std::cout << "[OK] Freed pages reused lowest first\n";
+
+        free_page(th, 1234);
+        free_page(th, 64);
+        freed = {64, 1234};
+        // no flush_table: teardown writes the bitmap back
+    }
+
+    TableHandle th(table);
+    assert(open_table(table, th) && "reopen failed");
+    assert(th.fsm.allocated_count() == 3 + 5001 - 2 && "Bitmap lost on reopen");
+    assert(!th.fsm.is_allocated(64) && !th.fsm.is_allocated(1234) && th.fsm.is_allocated(1233));
+    assert(allocate_page(th) == freed[0] && allocate_page(th) == freed[1]);
+    std::cout << "[OK] Bitmap persisted lazily and reloaded\n";
+
+    std::cout << "\n=== Cached Allocation Bitmap Test PASSED ===\n";
+}
+
+void test_multi_level_map() {
+    std::cout << "\n=== Multi-Level Free-Space Map Test ===\n";
+
+    const std::string table = "test_alloc_multi";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+
+    const uint32_t per_bitmap = FreeSpaceMap::PAGES_PER_BITMAP;
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "open_table failed");
+        assert(th.fsm.bitmap_count() == 1);
+
+        // run past the first bitmap, the old single page limit
+        uint32_t last = 0;
+        const uint32_t total = per_bitmap + 1000;
+        for (uint32_t i = 0; i < total; i++) {
+            uint32_t pid = allocate_page(th);
+            assert(pid != INVALID_PAGE_ID && "Allocation failed past the first bitmap");
+            assert(pid != per_bitmap && "The second bitmap's own page was handed out");
+            last = pid;
+        }
+        assert(th.fsm.bitmap_count() == 2 && "A second bitmap should have been added");
+        assert(last == total + 3 && "Pages should continue right after the second bitmap page");
+        std::cout << "[OK] Allocated " << total << " pages across " << th.fsm.bitmap_count() << " bitmaps\n";
+
+        // a page freed in the full first bitmap is found again through the summary
+        free_page(th, 777);
+        assert(allocate_page(th) == 777);
+        free_page(th, 778);
+        flush_table(th);
+    }
+
+    TableHandle th(table);
+    assert(open_table(table, th) && "reopen failed");
+    assert(th.fsm.bitmap_count() == 2 && "Bitmap count lost on reopen");
+    assert(!th.fsm.is_allocated(778) && th.fsm.is_allocated(per_bitmap) && th.fsm.is_allocated(per_bitmap + 1000));
+    assert(allocate_page(th) == 778);
+    assert(allocate_page(th) == per_bitmap + 1004 && "First bitmap should be full again");
+    std::cout << "[OK] Summary and bitmaps persisted across reopen\n";
+
+    std::cout << "\n=== Multi-Level Free-Space Map Test PASSED ===\n";
+}
+
+void test_level_extents() {
+    std::cout << "\n=== Extent Allocation Test ===\n";
+
+    const std::string table = "test_alloc_extent";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    // pages 3..63 share a word with the fixed pages, so the first extent starts at 64
+    uint32_t leaf = allocate_page(th, PageLevel::LEAF);
+    assert(leaf == 64 && "First extent should be the first wholly free word");
+
+    // interleaved leaf and internal splits still give each level a contiguous run
+    uint32_t internal = allocate_page(th, PageLevel::INTERNAL);
+    assert(internal == 128 && "Internal nodes should get an extent of their own");
+    for (uint32_t i = 1; i < FreeSpaceMap::EXTENT_PAGES; i++) {
+        uint32_t next_leaf = allocate_page(th, PageLevel::LEAF, leaf);
+        assert(next_leaf == leaf + 1 && "Leaf split should take the page after the split leaf");
+        leaf = next_leaf;
+        if (i % 8 == 0) {
+            uint32_t next_internal = allocate_page(th, PageLevel::INTERNAL, internal);
+            assert(next_internal == internal + 1);
+            internal = next_internal;
+        }
+    }
+    std::cout << "[OK] Leaves 64.." << leaf << " and internal nodes 128.." << internal << " are contiguous\n";
+
+    // plain allocations fill the low pages and leave the internal extent alone
+    for (uint32_t i = 0; i < 61; i++) {
+        assert(allocate_page(th) == 3 + i);
+    }
+    assert(allocate_page(th) == 192 && "Plain allocation took a page from an active extent");
+
+    // the leaf extent is used up: the page after it belongs to internal nodes, so a new one starts
+    uint32_t next_leaf = allocate_page(th, PageLevel::LEAF, leaf);
+    assert(next_leaf == 256 && "Leaf should move to a fresh extent");
+    std::cout << "[OK] Plain allocations and new extents skip reserved runs\n";
+
+    std::cout << "\n=== Extent Allocation Test PASSED ===\n";
+}
+
+void test_deferred_frees() {
+    std::cout << "\n=== Deferred Free List Test ===\n";
+
+    const std::string table = "test_alloc_deferred";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+
+    const uint32_t count = 20000;
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "open_table failed");
+        for (uint32_t i = 0; i < count; i++) {
+            allocate_page(th);
+        }
+
+        // a mass delete only queues the pages, nothing reaches the pool
+        uint64_t hits = th.bpm.hits(), misses = th.bpm.misses();
+        for (uint32_t pid = 3 + count - 1; pid >= 1003; pid--) {
+            free_page(th, pid);
+        }
+        free_page(th, 1003); // freed twice
+        assert(th.fsm.pending_frees() == count - 1000 + 1);
+        assert(th.bpm.hits() == hits && th.bpm.misses() == misses && "Free touched the bitmap page");
+        std::cout << "[OK] " << th.fsm.pending_frees() << " frees queued\n";
+
+        // the next allocation applies the batch and reuses the lowest freed page
+        assert(allocate_page(th) == 1003);
+        assert(th.fsm.pending_frees() == 0);
+        assert(th.fsm.allocated_count() == 3 + 1001);
+
+        free_page(th, 500);
+        flush_table(th);
+        assert(th.fsm.pending_frees() == 0 && "flush_table should apply queued frees");
+    }
+
+    TableHandle th(table);
+    assert(open_table(table, th) && "reopen failed");
+    assert(th.fsm.allocated_count() == 3 + 1000 && "Batched frees lost on reopen");
+    assert(allocate_page(th) == 500 && allocate_page(th) == 1004);
+    std::cout << "[OK] Batch applied once and persisted\n";
+
+    std::cout << "\n=== Deferred Free List Test PASSED ===\n";
+}
+
 int main()
 {
     try
     {
         test_table_and_page_allocator();
+        test_cached_bitmap();
+        test_multi_level_map();
+        test_level_extents();
+        test_deferred_frees();
         std::cout << "page_insert validation completed successfully!" << std::endl;
         return 0;
     }
@@ -5,6 +5,7 @@
 #include <cassert>
 #include <cstring>
 #include <string>
+#include <vector>
 
 void debug_print_slot(Page &page)
 {
@@ -68,9 +69,10 @@ Page* validate_page_insert()
     std::cout << "\nVerifying slot order + payloads:\n";
     for (uint16_t i = 0; i < header->cell_count; ++i)
     {
-        uint16_t key_len = 0;
-        const uint8_t *key_ptr = slot_key(*page, i, key_len);
-        assert(key_len == 1);
+        std::vector<uint8_t> key;
+        slot_key(*page, i, key);
+        const uint8_t *key_ptr = key.data();
+        assert(key.size() == 1);
         assert(std::memcmp(key_ptr, expected_keys[i], 1) == 0);
 
         uint16_t val_len = 0;
@@ -101,12 +103,12 @@ Page* validate_page_insert()
     dm.flush();
 
     Page page_from_disk1;
-    dm.read_page(0, reinterpret_cast<char*>(page_from_disk1.data));
+    dm.read_page(0, page_from_disk1.data);
     std::cout << "After first read from disk:\n";
     debug_print_slot(page_from_disk1);
 
     Page page_from_disk2;
-    dm.read_page(0, reinterpret_cast<char*>(page_from_disk2.data));
+    dm.read_page(0, page_from_disk2.data);
     std::cout << "After second read from disk:\n";
     debug_print_slot(page_from_disk2);
 
@@ -41,7 +41,7 @@ void validate_page() {
     dm.flush();
 
     Page page2;
-    dm.read_page(0, reinterpret_cast<char*>(page2.data));
+    dm.read_page(0, page2.data);
 
     std::cout << "Slots AFTER disk read:\n";
     debug_print_slot(page2);
@@ -7,6 +7,8 @@
 #include <iomanip>
 #include <fstream>
 #include <functional>
+#include <algorithm>
+#include <random>
 #include "storage/btree.hpp"
 #include "storage/table_handle.hpp"
 #include "storage/page.hpp"
@@ -320,6 +322,1083 @@ void test_btree_email_keys() {
     std::cout << "\n=== Email Keys Test PASSED ===\n";
 }
 
+void test_btree_mmap_read_only() {
+    std::cout << "\n=== B+ Tree Memory-Mapped Read-Only Test ===\n";
+
+    const std::string table = "test_btree_mmap";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    const int num_keys = 3000;
+    assert(create_table(table) && "create_table failed");
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "open_table failed");
+        for (int i = 0; i < num_keys; i++) {
+            std::string k = "key" + std::to_string(i);
+            std::string v = "val" + std::to_string(i);
+            Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+            Value value = {(const uint8_t*)v.c_str(), (uint16_t)v.size()};
+            assert(btree_insert(th, key, value) && "btree_insert failed");
+        }
+        flush_table(th);
+    }
+    std::cout << "[OK] Wrote " << num_keys << " keys through the buffer pool\n";
+
+    TableHandle th(table, TableOpenMode::MMAP_READ_ONLY);
+    assert(open_table(table, th, TableOpenMode::MMAP_READ_ONLY) && "mmap open failed");
+    assert(th.read_only() && th.dm.options().read_only && "File should be open read-only");
+
+    // a wrong name fails instead of leaving an empty file behind
+    const std::string missing = "data/test_btree_mmap_missing.db";
+    remove(missing.c_str());
+    bool threw = false;
+    try {
+        TableHandle none("test_btree_mmap_missing", TableOpenMode::MMAP_READ_ONLY);
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    FILE* created = fopen(missing.c_str(), "rb");
+    assert(threw && !created && "Read-only open must not create the file");
+
+    const uint8_t* map_begin = th.mapped.page(0)->data;
+    const uint8_t* map_end = map_begin + static_cast<uint64_t>(th.mapped.page_count()) * PAGE_SIZE;
+    for (int i = 0; i < num_keys; i++) {
+        std::string k = "key" + std::to_string(i);
+        std::string v = "val" + std::to_string(i);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        Value result;
+        assert(btree_search(th, key, result) && "btree_search failed on mapped table");
+        assert(result.size == v.size() && memcmp(result.data, v.c_str(), v.size()) == 0);
+        assert(result.data >= map_begin && result.data < map_end && "Value should point into the mapping");
+    }
+    assert(th.bpm.hits() == 0 && th.bpm.misses() == 0 && "Mapped lookups must bypass the buffer pool");
+    std::cout << "[OK] " << num_keys << " zero-copy lookups served from the mapping\n";
+
+    Key key = {(const uint8_t*)"new", 3};
+    Value value = {(const uint8_t*)"x", 1};
+    assert(!btree_insert(th, key, value) && "Insert into a read-only table should fail");
+    std::cout << "[OK] Read-only table rejects inserts\n";
+
+    // flip a byte of the root, every lookup through a fresh mapping has to notice
+    {
+        FILE* f = fopen(path.c_str(), "r+b");
+        assert(f && "Could not reopen the table file");
+        long offset = static_cast<long>(th.root_page) * PAGE_SIZE + sizeof(PageHeader) + 17;
+        fseek(f, offset, SEEK_SET);
+        int byte = fgetc(f);
+        fseek(f, offset, SEEK_SET);
+        fputc(byte ^ 0xFF, f);
+        fclose(f);
+    }
+    TableHandle corrupt(table, TableOpenMode::MMAP_READ_ONLY);
+    assert(open_table(table, corrupt, TableOpenMode::MMAP_READ_ONLY) && "mmap open failed");
+    threw = false;
+    try {
+        Key k0 = {(const uint8_t*)"key0", 4};
+        Value result;
+        btree_search(corrupt, k0, result);
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw && "Corrupt mapped page must not be read");
+    std::cout << "[OK] Corrupted mapped page detected on first touch\n";
+
+    std::cout << "\n=== Memory-Mapped Read-Only Test PASSED ===\n";
+}
+
+// fixed width so byte order matches numeric order
+static std::string scan_key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%06d", i);
+    return buf;
+}
+
+void test_btree_cursor_scan() {
+    std::cout << "\n=== B+ Tree Cursor Scan Test ===\n";
+
+    const std::string table = "test_btree_cursor";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    BTreeCursor empty(th);
+    assert(!empty.seek_first() && !empty.valid() && "Empty tree should have nothing to scan");
+
+    // even numbers only, inserted out of order so splits happen all over the tree
+    const int num_keys = 5000;
+    std::vector<int> order;
+    for (int i = 0; i < num_keys; i++) {
+        order.push_back(i * 2);
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+    for (int n : order) {
+        std::string k = scan_key(n);
+        std::string v = "val" + std::to_string(n);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        Value value = {(const uint8_t*)v.c_str(), (uint16_t)v.size()};
+        assert(btree_insert(th, key, value) && "btree_insert failed");
+    }
+
+    // full scan follows the leaf chain in key order
+    BTreeCursor cursor(th);
+    int count = 0;
+    for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+        std::string k = scan_key(count * 2);
+        std::string v = "val" + std::to_string(count * 2);
+        Key key = cursor.key();
+        Value value = cursor.value();
+        assert(key.size == k.size() && memcmp(key.data, k.c_str(), k.size()) == 0 && "Scan out of order");
+        assert(value.size == v.size() && memcmp(value.data, v.c_str(), v.size()) == 0);
+        count++;
+    }
+    assert(count == num_keys && "Full scan missed keys");
+    assert(!cursor.valid());
+    std::cout << "[OK] Full scan returned " << count << " keys in order\n";
+
+    // range [1001, 3001): seek lands on the first key >= the missing odd bound
+    std::string lo = scan_key(1001), hi = scan_key(3001);
+    Key lo_key = {(const uint8_t*)lo.c_str(), (uint16_t)lo.size()};
+    Key hi_key = {(const uint8_t*)hi.c_str(), (uint16_t)hi.size()};
+    int in_range = 0;
+    for (bool ok = cursor.seek(lo_key); ok; ok = cursor.next()) {
+        Key key = cursor.key();
+        if (compare_keys(key.data, key.size, hi_key.data, hi_key.size) >= 0) {
+            break;
+        }
+        std::string expected = scan_key(1002 + in_range * 2);
+        assert(memcmp(key.data, expected.c_str(), expected.size()) == 0);
+        in_range++;
+    }
+    assert(in_range == 1000 && "Range scan returned the wrong number of keys");
+    std::cout << "[OK] Range scan returned " << in_range << " keys\n";
+
+    std::string past = scan_key(num_keys * 2);
+    Key past_key = {(const uint8_t*)past.c_str(), (uint16_t)past.size()};
+    assert(!cursor.seek(past_key) && "Seek past the last key should fail");
+    std::cout << "[OK] Seek past the end is invalid\n";
+
+    std::cout << "\n=== Cursor Scan Test PASSED ===\n";
+}
+
+void test_btree_reverse_scan() {
+    std::cout << "\n=== B+ Tree Reverse Scan Test ===\n";
+
+    const std::string table = "test_btree_reverse_scan";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    BTreeCursor empty(th);
+    assert(!empty.seek_last() && "Empty tree should have no last key");
+
+    const int num_keys = 5000;
+    std::vector<int> order;
+    for (int i = 0; i < num_keys; i++) {
+        order.push_back(i * 2);
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(7));
+    for (int n : order) {
+        std::string k = scan_key(n);
+        std::string v = "val" + std::to_string(n);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        Value value = {(const uint8_t*)v.c_str(), (uint16_t)v.size()};
+        assert(btree_insert(th, key, value) && "btree_insert failed");
+    }
+
+    // full scan backwards through the prev links
+    BTreeCursor cursor(th);
+    int count = 0;
+    for (bool ok = cursor.seek_last(); ok; ok = cursor.prev()) {
+        int n = (num_keys - 1 - count) * 2;
+        std::string k = scan_key(n);
+        std::string v = "val" + std::to_string(n);
+        Key key = cursor.key();
+        Value value = cursor.value();
+        assert(key.size == k.size() && memcmp(key.data, k.c_str(), k.size()) == 0 && "Reverse scan out of order");
+        assert(value.size == v.size() && memcmp(value.data, v.c_str(), v.size()) == 0);
+        count++;
+    }
+    assert(count == num_keys && "Reverse scan missed keys");
+    std::cout << "[OK] Reverse scan returned " << count << " keys in descending order\n";
+
+    // "latest 10 before X": seek_for_prev on a missing key lands on the next smaller one
+    std::string bound = scan_key(6001);
+    Key bound_key = {(const uint8_t*)bound.c_str(), (uint16_t)bound.size()};
+    int taken = 0;
+    for (bool ok = cursor.seek_for_prev(bound_key); ok && taken < 10; ok = cursor.prev()) {
+        std::string expected = scan_key(6000 - taken * 2);
+        assert(memcmp(cursor.key().data, expected.c_str(), expected.size()) == 0);
+        taken++;
+    }
+    assert(taken == 10);
+
+    // an exact match is included, and direction can change mid scan
+    std::string exact = scan_key(100);
+    Key exact_key = {(const uint8_t*)exact.c_str(), (uint16_t)exact.size()};
+    assert(cursor.seek_for_prev(exact_key));
+    assert(memcmp(cursor.key().data, exact.c_str(), exact.size()) == 0);
+    assert(cursor.prev() && cursor.next() && memcmp(cursor.key().data, exact.c_str(), exact.size()) == 0);
+
+    std::string before = scan_key(0);
+    Key before_key = {(const uint8_t*)before.c_str(), (uint16_t)(before.size() - 1)};
+    assert(!cursor.seek_for_prev(before_key) && "Nothing sorts before the first key");
+    std::cout << "[OK] seek_for_prev and direction changes\n";
+
+    std::cout << "\n=== Reverse Scan Test PASSED ===\n";
+}
+
+void test_btree_delete() {
+    std::cout << "\n=== B+ Tree Delete Test ===\n";
+
+    const std::string table = "test_btree_delete";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    // long values so the tree is a few levels deep
+    const int num_keys = 20000;
+    const std::string padding(60, 'x');
+    std::vector<int> order;
+    for (int i = 0; i < num_keys; i++) {
+        order.push_back(i);
+    }
+    std::mt19937 rng(11);
+    std::shuffle(order.begin(), order.end(), rng);
+    for (int n : order) {
+        std::string k = scan_key(n);
+        std::string v = "val" + std::to_string(n) + padding;
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        Value value = {(const uint8_t*)v.c_str(), (uint16_t)v.size()};
+        assert(btree_insert(th, key, value) && "btree_insert failed");
+    }
+    uint32_t pages_full = th.fsm.allocated_count();
+
+    std::string missing = scan_key(num_keys);
+    Key missing_key = {(const uint8_t*)missing.c_str(), (uint16_t)missing.size()};
+    assert(!btree_delete(th, missing_key) && "Deleting a missing key should fail");
+
+    // delete 90% in random order, merges and borrows happen on every level
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<bool> present(num_keys, true);
+    const int num_deleted = num_keys * 9 / 10;
+    for (int i = 0; i < num_deleted; i++) {
+        std::string k = scan_key(order[i]);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        assert(btree_delete(th, key) && "btree_delete failed");
+        assert(!btree_delete(th, key) && "Key deleted twice");
+        present[order[i]] = false;
+    }
+    std::cout << "[OK] Deleted " << num_deleted << " keys\n";
+
+    for (int n = 0; n < num_keys; n++) {
+        std::string k = scan_key(n);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        Value result;
+        assert(btree_search(th, key, result) == present[n] && "Search disagrees after deletes");
+    }
+
+    // the leaf chain is intact both ways
+    int forward = 0, backward = 0;
+    BTreeCursor cursor(th);
+    for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+        forward++;
+    }
+    for (bool ok = cursor.seek_last(); ok; ok = cursor.prev()) {
+        backward++;
+    }
+    assert(forward == num_keys - num_deleted && backward == forward && "Leaf chain broken by merges");
+    uint32_t pages_left = th.fsm.allocated_count();
+    assert(pages_left < pages_full / 2 && "Merged pages were not freed");
+    std::cout << "[OK] Remaining keys found, pages " << pages_full << " -> " << pages_left << "\n";
+
+    // empty the tree completely: the root collapses back to a single leaf
+    for (int i = num_deleted; i < num_keys; i++) {
+        std::string k = scan_key(order[i]);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        assert(btree_delete(th, key) && "btree_delete failed");
+    }
+    assert(!cursor.seek_first() && "Tree should be empty");
+    {
+        PageGuard root = th.bpm.fetch_page_guard(th.root_page);
+        assert(get_header(root.page())->page_level == PageLevel::LEAF && "Root did not collapse");
+    }
+    // merges always keep the left page, so the first leaf (page 2) ends up as the root again
+    assert(th.root_page == 2 && th.fsm.allocated_count() == 3 && "Only the fixed pages should remain");
+    std::cout << "[OK] Root collapsed to one leaf, every other page freed\n";
+
+    // and the tree is usable again
+    for (int n = 0; n < 1000; n++) {
+        std::string k = scan_key(n);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        assert(btree_insert(th, key, key) && "Insert after delete failed");
+    }
+    flush_table(th);
+    std::cout << "[OK] Reinserted into the emptied tree\n";
+
+    std::cout << "\n=== Delete Test PASSED ===\n";
+}
+
+void test_btree_compaction() {
+    std::cout << "\n=== B+ Tree In-Page Compaction Test ===\n";
+
+    const std::string table = "test_btree_compaction";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    // fill the root leaf until one more record would not fit
+    const std::string value(100, 'v');
+    Value v = {(const uint8_t*)value.c_str(), (uint16_t)value.size()};
+    int count = 0;
+    while (true) {
+        std::string k = scan_key(count);
+        PageGuard root = th.bpm.fetch_page_guard(th.root_page);
+        if (!can_insert(root.page(), record_size((uint16_t)k.size(), v.size))) {
+            break;
+        }
+        root = PageGuard();
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        assert(btree_insert(th, key, v) && "btree_insert failed");
+        count++;
+    }
+    uint32_t root_before = th.root_page;
+    uint32_t pages_before = th.fsm.allocated_count();
+
+    // delete every other key: half the page is dead bytes, the contiguous gap is unchanged
+    for (int i = 0; i < count; i += 2) {
+        std::string k = scan_key(i);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        assert(btree_delete(th, key) && "btree_delete failed");
+    }
+
+    // churn: new keys reuse the dead space instead of splitting the leaf
+    for (int i = 0; i < count / 2; i++) {
+        std::string k = scan_key(count + i);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        assert(btree_insert(th, key, v) && "btree_insert failed");
+    }
+    assert(th.root_page == root_before && th.fsm.allocated_count() == pages_before && "Leaf split despite dead space");
+    {
+        PageGuard root = th.bpm.fetch_page_guard(th.root_page);
+        assert(get_header(root.page())->page_level == PageLevel::LEAF);
+        assert(get_header(root.page())->cell_count == count - (count + 1) / 2 + count / 2);
+    }
+    for (int i = 1; i < count + count / 2; i += (i < count ? 2 : 1)) {
+        std::string k = scan_key(i);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        Value result;
+        assert(btree_search(th, key, result) && result.size == value.size());
+    }
+    std::cout << "[OK] " << count / 2 << " inserts into a leaf full of dead records, no split\n";
+
+    std::cout << "\n=== In-Page Compaction Test PASSED ===\n";
+}
+
+void test_btree_bulk_load() {
+    std::cout << "\n=== B+ Tree Bulk Load Test ===\n";
+
+    const std::string table = "test_btree_bulk";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+
+    // 150k rows with long keys, so there are several internal levels
+    const int num_keys = 150000;
+    const std::string padding(40, 'p');
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "open_table failed");
+
+        int n = 0;
+        std::string k, v;
+        auto source = [&](Key& key, Value& value) {
+            if (n == num_keys) {
+                return false;
+            }
+            k = scan_key(n) + padding;
+            v = "val" + std::to_string(n);
+            key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+            value = {(const uint8_t*)v.c_str(), (uint16_t)v.size()};
+            n++;
+            return true;
+        };
+        assert(btree_bulk_load(th, source, 0.8) && "btree_bulk_load failed");
+        assert(th.root_page != 2 && "Root should be an internal page");
+
+        // a second load into the now non-empty tree is refused
+        n = 0;
+        assert(!btree_bulk_load(th, source) && "Bulk load into a non-empty tree should fail");
+        flush_table(th);
+    }
+    std::cout << "[OK] Bulk loaded " << num_keys << " rows\n";
+
+    TableHandle th(table);
+    assert(open_table(table, th) && "reopen failed");
+    for (int n = 0; n < num_keys; n += 7) {
+        std::string k = scan_key(n) + padding;
+        std::string v = "val" + std::to_string(n);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        Value result;
+        assert(btree_search(th, key, result) && "Bulk loaded key not found");
+        assert(result.size == v.size() && memcmp(result.data, v.c_str(), v.size()) == 0);
+    }
+
+    // leaves were written in order, so the chain walks forward through the file
+    int count = 0, backwards_steps = 0;
+    uint32_t last_leaf = 0;
+    BTreeCursor cursor(th);
+    for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+        PageGuard leaf = find_leaf_page(th, cursor.key());
+        if (leaf.page_id() < last_leaf) {
+            backwards_steps++;
+        }
+        last_leaf = leaf.page_id();
+        count++;
+    }
+    assert(count == num_keys && backwards_steps == 0 && "Leaf chain out of file order");
+    std::cout << "[OK] All rows found, leaf chain follows file order\n";
+
+    // the loaded tree takes normal inserts and deletes
+    for (int n = 0; n < 2000; n++) {
+        std::string k = scan_key(n) + padding;
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        assert(btree_delete(th, key) && "Delete from bulk loaded tree failed");
+        std::string k2 = scan_key(num_keys + n);
+        Key key2 = {(const uint8_t*)k2.c_str(), (uint16_t)k2.size()};
+        assert(btree_insert(th, key2, key2) && "Insert into bulk loaded tree failed");
+    }
+    std::cout << "[OK] Inserts and deletes work on the loaded tree\n";
+
+    // out of order input is rejected and leaves the table empty
+    const std::string bad_table = "test_btree_bulk_bad";
+    std::string bad_path = "data/" + bad_table + ".db";
+    remove(bad_path.c_str());
+    assert(create_table(bad_table));
+    TableHandle bad(bad_table);
+    assert(open_table(bad_table, bad));
+    int i = 0;
+    std::string bk;
+    auto unsorted = [&](Key& key, Value& value) {
+        if (i == 5000) {
+            return false;
+        }
+        bk = scan_key(i == 4000 ? 10 : i);
+        key = {(const uint8_t*)bk.c_str(), (uint16_t)bk.size()};
+        value = key;
+        i++;
+        return true;
+    };
+    assert(!btree_bulk_load(bad, unsorted) && "Unsorted input should be rejected");
+    BTreeCursor bad_cursor(bad);
+    assert(!bad_cursor.seek_first() && "Failed load should leave the tree empty");
+    assert(bad.fsm.allocated_count() == 3 && "Failed load should free its pages");
+    std::cout << "[OK] Unsorted input rejected, pages given back\n";
+
+    std::cout << "\n=== Bulk Load Test PASSED ===\n";
+}
+
+void test_btree_insert_batch() {
+    std::cout << "\n=== B+ Tree Batch Insert Test ===\n";
+
+    const std::string batch_table = "test_btree_batch";
+    const std::string single_table = "test_btree_batch_single";
+    remove(("data/" + batch_table + ".db").c_str());
+    remove(("data/" + single_table + ".db").c_str());
+    assert(create_table(batch_table) && create_table(single_table));
+    TableHandle th(batch_table);
+    TableHandle single(single_table);
+    assert(open_table(batch_table, th) && open_table(single_table, single));
+
+    // ten batches of 2000 clustered keys in random order, the same data key by key elsewhere
+    const int batches = 10, batch_size = 2000;
+    std::mt19937 rng(3);
+    std::vector<std::string> keys;
+    for (int b = 0; b < batches; b++) {
+        for (int i = 0; i < batch_size; i++) {
+            keys.push_back(scan_key(i * batches + b));
+        }
+    }
+
+    size_t inserted = 0;
+    uint64_t single_fetches = 0, batch_fetches = 0;
+    for (int b = 0; b < batches; b++) {
+        std::vector<std::string> chunk(keys.begin() + b * batch_size, keys.begin() + (b + 1) * batch_size);
+        std::shuffle(chunk.begin(), chunk.end(), rng);
+        chunk.push_back(chunk[0]); // repeated inside the batch
+
+        std::vector<BatchEntry> batch;
+        for (const std::string& k : chunk) {
+            Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+            batch.push_back({key, key});
+        }
+        uint64_t before = th.bpm.hits() + th.bpm.misses();
+        inserted += btree_insert_batch(th, batch);
+        batch_fetches += th.bpm.hits() + th.bpm.misses() - before;
+
+        before = single.bpm.hits() + single.bpm.misses();
+        for (const std::string& k : chunk) {
+            Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+            btree_insert(single, key, key);
+        }
+        single_fetches += single.bpm.hits() + single.bpm.misses() - before;
+    }
+    assert(inserted == keys.size() && "Batch insert count wrong");
+    std::cout << "[OK] Inserted " << inserted << " keys in " << batches << " batches, page fetches "
+              << single_fetches << " -> " << batch_fetches << "\n";
+    assert(batch_fetches * 5 < single_fetches && "Batching should save most page fetches");
+
+    // every key is there, and in order
+    int count = 0;
+    BTreeCursor cursor(th);
+    for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+        std::string expected = scan_key(count);
+        assert(cursor.key().size == expected.size() && memcmp(cursor.key().data, expected.c_str(), expected.size()) == 0);
+        count++;
+    }
+    assert(count == batches * batch_size);
+
+    // a batch of existing keys changes nothing
+    std::vector<BatchEntry> again;
+    for (int i = 0; i < 100; i++) {
+        Key key = {(const uint8_t*)keys[i].c_str(), (uint16_t)keys[i].size()};
+        again.push_back({key, key});
+    }
+    assert(btree_insert_batch(th, again) == 0 && "Existing keys should be skipped");
+    std::cout << "[OK] All keys present in order, duplicates skipped\n";
+
+    std::cout << "\n=== Batch Insert Test PASSED ===\n";
+}
+
+void test_btree_multi_get() {
+    std::cout << "\n=== B+ Tree Multi-Get Test ===\n";
+
+    const std::string table = "test_btree_multi_get";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    // even keys only
+    const int num_keys = 20000;
+    std::vector<BatchEntry> rows;
+    std::vector<std::string> row_keys, row_values;
+    for (int i = 0; i < num_keys; i++) {
+        row_keys.push_back(scan_key(i * 2));
+        row_values.push_back("val" + std::to_string(i * 2));
+    }
+    for (int i = 0; i < num_keys; i++) {
+        rows.push_back({{(const uint8_t*)row_keys[i].c_str(), (uint16_t)row_keys[i].size()},
+                        {(const uint8_t*)row_values[i].c_str(), (uint16_t)row_values[i].size()}});
+    }
+    assert(btree_insert_batch(th, rows) == (size_t)num_keys);
+
+    // 1000 clustered probes in random order, half of them odd (missing)
+    std::vector<int> probes;
+    for (int i = 0; i < 1000; i++) {
+        probes.push_back(10000 + i);
+    }
+    std::shuffle(probes.begin(), probes.end(), std::mt19937(9));
+    std::vector<std::string> probe_keys;
+    for (int n : probes) {
+        probe_keys.push_back(scan_key(n));
+    }
+    std::vector<Key> keys;
+    for (const std::string& k : probe_keys) {
+        keys.push_back({(const uint8_t*)k.c_str(), (uint16_t)k.size()});
+    }
+
+    uint64_t before = th.bpm.hits() + th.bpm.misses();
+    std::vector<MultiGetResult> results = btree_multi_get(th, keys);
+    uint64_t multi_fetches = th.bpm.hits() + th.bpm.misses() - before;
+
+    before = th.bpm.hits() + th.bpm.misses();
+    assert(results.size() == keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        Value value;
+        bool found = btree_search(th, keys[i], value);
+        assert(results[i].found == found && found == (probes[i] % 2 == 0) && "Result in wrong slot");
+        if (found) {
+            assert(results[i].value.size() == value.size && memcmp(results[i].value.data(), value.data, value.size) == 0);
+        }
+    }
+    uint64_t loop_fetches = th.bpm.hits() + th.bpm.misses() - before;
+    std::cout << "[OK] " << keys.size() << " probes in input order, page fetches " << loop_fetches
+              << " -> " << multi_fetches << "\n";
+    assert(multi_fetches * 5 < loop_fetches && "Multi-get should share the descent");
+
+    std::vector<Key> none;
+    assert(btree_multi_get(th, none).empty());
+
+    std::cout << "\n=== Multi-Get Test PASSED ===\n";
+}
+
+void test_btree_internal_split() {
+    std::cout << "\n=== B+ Tree Internal Split Test ===\n";
+
+    const std::string table = "test_btree_internal_split";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    // long keys keep the fan-out low, so internal nodes split and the root grows twice
+    const int num_keys = 30000;
+    std::vector<int> order(num_keys);
+    for (int i = 0; i < num_keys; i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(5));
+    auto long_key = [](int n) { return scan_key(n) + std::string(230, 'k'); };
+
+    uint64_t max_fetches = 0;
+    for (int n : order) {
+        std::string k = long_key(n);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        uint64_t before = th.bpm.hits() + th.bpm.misses();
+        assert(btree_insert(th, key, key) && "Insert failed");
+        max_fetches = std::max(max_fetches, th.bpm.hits() + th.bpm.misses() - before);
+    }
+
+    int height = 1;
+    {
+        PageGuard node = th.bpm.fetch_page_guard(th.root_page);
+        while (get_header(node.page())->page_level == PageLevel::INTERNAL) {
+            node = th.bpm.fetch_page_guard(*reinterpret_cast<uint32_t*>(get_header(node.page())->reserved));
+            height++;
+        }
+    }
+    assert(height >= 3 && "Tree should have split internal nodes");
+
+    // a split writes the node, its new sibling and the parent, never the moved children
+    std::cout << "[OK] Height " << height << ", at most " << max_fetches << " page fetches per insert\n";
+    assert(max_fetches <= (uint64_t)(3 * height + 2) && "Internal split fetched the moved children");
+
+    for (int i = 0; i < num_keys; i++) {
+        std::string k = long_key(i);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        Value value;
+        assert(btree_search(th, key, value) && value.size == k.size() && "Key lost after internal splits");
+    }
+    int count = 0;
+    BTreeCursor cursor(th);
+    for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+        std::string expected = long_key(count++);
+        assert(cursor.key().size == expected.size() && memcmp(cursor.key().data, expected.c_str(), expected.size()) == 0);
+    }
+    assert(count == num_keys);
+    std::cout << "[OK] All " << num_keys << " keys found and in order\n";
+
+    // a lost leftmost child is reported as a failed lookup, not replaced by some other child
+    {
+        PageGuard root = th.bpm.fetch_page_guard(th.root_page);
+        uint32_t* leftmost = reinterpret_cast<uint32_t*>(get_header(root.page())->reserved);
+        uint32_t saved = *leftmost;
+        *leftmost = 0;
+        std::string k = long_key(0);
+        Value value;
+        assert(!btree_search(th, {(const uint8_t*)k.c_str(), (uint16_t)k.size()}, value) &&
+               "Lookup through a corrupt root should fail");
+        *leftmost = saved;
+        assert(btree_search(th, {(const uint8_t*)k.c_str(), (uint16_t)k.size()}, value));
+    }
+    std::cout << "[OK] Corrupt leftmost child reported\n";
+
+    std::cout << "\n=== Internal Split Test PASSED ===\n";
+}
+
+void test_btree_overflow_values() {
+    std::cout << "\n=== B+ Tree Long Key And Overflow Value Test ===\n";
+
+    const std::string table = "test_btree_overflow";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+
+    // every 10th row carries a document of up to ~60 KB, the rest are small
+    const int num_keys = 2000;
+    auto doc = [](int n) {
+        std::string v = "{\"id\":" + std::to_string(n) + ",\"body\":\"";
+        v += std::string(1500 + (n * 7919) % 58000, (char)('a' + n % 26));
+        return v + "\"}";
+    };
+    auto row_value = [&](int n) { return n % 10 == 0 ? doc(n) : "val" + std::to_string(n); };
+
+    uint32_t pages_small = 0;
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "open_table failed");
+        std::vector<int> order(num_keys);
+        for (int i = 0; i < num_keys; i++) {
+            order[i] = i;
+        }
+        std::shuffle(order.begin(), order.end(), std::mt19937(13));
+        for (int n : order) {
+            std::string k = scan_key(n);
+            std::string v = row_value(n);
+            Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+            Value value = {(const uint8_t*)v.c_str(), (uint16_t)v.size()};
+            assert(btree_insert(th, key, value) && "btree_insert failed");
+        }
+
+        // the documents live outside the leaves: a leaf still holds many rows
+        PageGuard leaf = find_leaf_page(th, {(const uint8_t*)"key001000", 9});
+        assert(get_header(leaf.page())->cell_count > 50 && "Large values crowd the leaves");
+        leaf = PageGuard();
+
+        for (int n = 0; n < num_keys; n++) {
+            std::string k = scan_key(n);
+            std::string v = row_value(n);
+            Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+            Value result;
+            assert(btree_search(th, key, result) && result.size == v.size() &&
+                   memcmp(result.data, v.c_str(), v.size()) == 0 && "Value mismatch");
+        }
+        int count = 0;
+        BTreeCursor cursor(th);
+        for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+            std::string v = row_value(count++);
+            assert(cursor.value().size == v.size() && memcmp(cursor.value().data, v.c_str(), v.size()) == 0);
+        }
+        assert(count == num_keys);
+        std::vector<std::string> probe_keys = {scan_key(0), scan_key(15), scan_key(1990), scan_key(num_keys)};
+        std::vector<Key> probes;
+        for (const std::string& k : probe_keys) {
+            probes.push_back({(const uint8_t*)k.c_str(), (uint16_t)k.size()});
+        }
+        std::vector<MultiGetResult> results = btree_multi_get(th, probes);
+        assert(results[0].found && results[0].value.size() == doc(0).size());
+        assert(results[1].found && std::string(results[1].value.begin(), results[1].value.end()) == row_value(15));
+        assert(results[2].found && std::string(results[2].value.begin(), results[2].value.end()) == doc(1990));
+        assert(!results[3].found);
+        std::cout << "[OK] " << num_keys / 10 << " documents read back through search, cursor and multi-get\n";
+
+        // a rejected duplicate leaves no chain behind
+        uint32_t pages_full = th.fsm.allocated_count();
+        std::string dup_key = scan_key(20);
+        std::string dup_value = doc(20);
+        assert(!btree_insert(th, {(const uint8_t*)dup_key.c_str(), (uint16_t)dup_key.size()},
+                             {(const uint8_t*)dup_value.c_str(), (uint16_t)dup_value.size()}) &&
+               "Duplicate insert should fail");
+        assert(th.fsm.allocated_count() == pages_full && "Duplicate insert leaked overflow pages");
+
+        // deleting the documents gives their chains back
+        for (int n = 0; n < num_keys; n += 10) {
+            std::string k = scan_key(n);
+            Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+            assert(btree_delete(th, key) && "btree_delete failed");
+        }
+        pages_small = th.fsm.allocated_count();
+        assert(pages_small * 20 < pages_full && "Overflow pages were not freed");
+        std::cout << "[OK] Pages " << pages_full << " -> " << pages_small << " after deleting the documents\n";
+        flush_table(th);
+    }
+
+    TableHandle th(table);
+    assert(open_table(table, th) && "reopen failed");
+    assert(th.fsm.allocated_count() == pages_small);
+
+    // keys up to MAX_KEY_SIZE, past the old 256 byte limit, with overflowed values
+    for (int n = 0; n < 300; n++) {
+        std::string k = scan_key(n) + std::string(200 + (n * 37) % (MAX_KEY_SIZE - 208), 'k');
+        std::string v = doc(n);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        Value value = {(const uint8_t*)v.c_str(), (uint16_t)v.size()};
+        assert(btree_insert(th, key, value) && "Long key insert failed");
+    }
+    std::string too_long(MAX_KEY_SIZE + 1, 'k');
+    assert(!btree_insert(th, {(const uint8_t*)too_long.c_str(), (uint16_t)too_long.size()}, {nullptr, 0}) &&
+           "Key past MAX_KEY_SIZE should be rejected");
+    for (int n = 0; n < 300; n++) {
+        std::string k = scan_key(n) + std::string(200 + (n * 37) % (MAX_KEY_SIZE - 208), 'k');
+        std::string v = doc(n);
+        Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        Value result;
+        assert(btree_search(th, key, result) && result.size == v.size() && memcmp(result.data, v.c_str(), v.size()) == 0);
+    }
+    std::cout << "[OK] Keys up to " << MAX_KEY_SIZE << " bytes stored, longer ones rejected\n";
+
+    // bulk load writes the chains next to the leaves
+    const std::string bulk_table = "test_btree_overflow_bulk";
+    remove(("data/" + bulk_table + ".db").c_str());
+    assert(create_table(bulk_table));
+    TableHandle bulk(bulk_table);
+    assert(open_table(bulk_table, bulk));
+    int next = 0;
+    std::string k, v;
+    assert(btree_bulk_load(bulk, [&](Key& key, Value& value) {
+        if (next == num_keys) {
+            return false;
+        }
+        k = scan_key(next);
+        v = row_value(next++);
+        key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        value = {(const uint8_t*)v.c_str(), (uint16_t)v.size()};
+        return true;
+    }) && "Bulk load with overflow values failed");
+    for (int n = 0; n < num_keys; n += 7) {
+        std::string key_str = scan_key(n);
+        std::string expected = row_value(n);
+        Value result;
+        assert(btree_search(bulk, {(const uint8_t*)key_str.c_str(), (uint16_t)key_str.size()}, result));
+        assert(result.size == expected.size() && memcmp(result.data, expected.c_str(), expected.size()) == 0);
+    }
+    std::cout << "[OK] Bulk loaded documents read back\n";
+
+    std::cout << "\n=== Long Key And Overflow Value Test PASSED ===\n";
+}
+
+// Records per leaf, counted along the leaf chain from the leftmost leaf
+double average_leaf_records(TableHandle& th) {
+    PageGuard node = th.bpm.fetch_page_guard(th.root_page);
+    while (get_header(node.page())->page_level == PageLevel::INTERNAL) {
+        node = th.bpm.fetch_page_guard(*reinterpret_cast<uint32_t*>(get_header(node.page())->reserved));
+    }
+    uint32_t leaves = 0, records = 0;
+    while (true) {
+        leaves++;
+        records += get_header(node.page())->cell_count;
+        uint32_t next = leaf_next(node.page());
+        if (next == 0) {
+            break;
+        }
+        node = th.bpm.fetch_page_guard(next);
+    }
+    return static_cast<double>(records) / leaves;
+}
+
+void test_btree_prefix_compression() {
+    std::cout << "\n=== B+ Tree Leaf Prefix Compression Test ===\n";
+
+    const std::string table = "test_btree_prefix";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    // keys of a few tenants sharing a long path, only the tail differs between neighbours
+    const int num_keys = 20000;
+    auto tenant_key = [](int n) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), "tenants/acme-%02d/accounts/users/%06d@mail.example.com", n % 4, n / 4);
+        return std::string(buf);
+    };
+    std::vector<int> order(num_keys);
+    for (int i = 0; i < num_keys; i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(17));
+    for (int n : order) {
+        std::string k = tenant_key(n);
+        std::string v = "v" + std::to_string(n);
+        assert(btree_insert(th, {(const uint8_t*)k.c_str(), (uint16_t)k.size()},
+                            {(const uint8_t*)v.c_str(), (uint16_t)v.size()}) && "Insert failed");
+    }
+
+    // a full leaf without compression holds this many records
+    std::string sample = tenant_key(num_keys - 1);
+    uint32_t plain = (PAGE_DATA_END - sizeof(PageHeader)) / (record_size(sample.size(), 6) + sizeof(uint16_t));
+    double per_leaf = average_leaf_records(th);
+    std::cout << "[OK] " << per_leaf << " records per leaf, " << plain << " would fit uncompressed\n";
+    assert(per_leaf > plain && "Leaves should hold more records than fit uncompressed");
+
+    PageGuard leaf = find_leaf_page(th, {(const uint8_t*)sample.c_str(), (uint16_t)sample.size()});
+    uint16_t prefix_len;
+    page_prefix(leaf.page(), prefix_len);
+    assert(prefix_len > 30 && "Leaf should store the shared path once");
+    leaf = PageGuard();
+
+    // delete every other key, then check what is left by search and by scan
+    for (int n = 0; n < num_keys; n += 2) {
+        std::string k = tenant_key(n);
+        assert(btree_delete(th, {(const uint8_t*)k.c_str(), (uint16_t)k.size()}) && "Delete failed");
+    }
+    for (int n = 0; n < num_keys; n++) {
+        std::string k = tenant_key(n);
+        Value value;
+        bool found = btree_search(th, {(const uint8_t*)k.c_str(), (uint16_t)k.size()}, value);
+        assert(found == (n % 2 == 1) && "Wrong key set after deletes");
+        if (found) {
+            std::string v = "v" + std::to_string(n);
+            assert(value.size == v.size() && memcmp(value.data, v.c_str(), v.size()) == 0);
+        }
+    }
+    std::vector<std::string> expected;
+    for (int n = 1; n < num_keys; n += 2) {
+        expected.push_back(tenant_key(n));
+    }
+    std::sort(expected.begin(), expected.end());
+    size_t count = 0;
+    BTreeCursor cursor(th);
+    for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+        assert(count < expected.size());
+        Key key = cursor.key();
+        assert(std::string((const char*)key.data, key.size) == expected[count++] && "Scan out of order");
+    }
+    assert(count == expected.size());
+    std::cout << "[OK] " << count << " keys left after deletes, found by search and scan\n";
+
+    // bulk load packs the same keys by their compressed size
+    const std::string bulk_table = "test_btree_prefix_bulk";
+    remove(("data/" + bulk_table + ".db").c_str());
+    assert(create_table(bulk_table));
+    TableHandle bulk(bulk_table);
+    assert(open_table(bulk_table, bulk));
+    size_t next = 0;
+    std::string v = "v00000";
+    assert(btree_bulk_load(bulk, [&](Key& key, Value& value) {
+        if (next == expected.size()) {
+            return false;
+        }
+        const std::string& k = expected[next++];
+        key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        value = {(const uint8_t*)v.c_str(), (uint16_t)v.size()};
+        return true;
+    }, 1.0) && "Bulk load failed");
+    per_leaf = average_leaf_records(bulk);
+    std::cout << "[OK] Bulk load: " << per_leaf << " records per leaf\n";
+    assert(per_leaf > plain * 1.5 && "Bulk loaded leaves should be packed by compressed size");
+    for (size_t i = 0; i < expected.size(); i += 13) {
+        Value value;
+        assert(btree_search(bulk, {(const uint8_t*)expected[i].c_str(), (uint16_t)expected[i].size()}, value));
+    }
+
+    std::cout << "\n=== Leaf Prefix Compression Test PASSED ===\n";
+}
+
+// Longest separator in any internal node, and the height of the tree
+size_t longest_separator(TableHandle& th, int& height) {
+    size_t longest = 0;
+    height = 1;
+    std::vector<uint32_t> level = {th.root_page};
+    while (true) {
+        std::vector<uint32_t> below;
+        for (uint32_t page_id : level) {
+            PageGuard node = th.bpm.fetch_page_guard(page_id);
+            Page& page = node.page();
+            if (get_header(page)->page_level == PageLevel::LEAF) {
+                return longest;
+            }
+            below.push_back(*reinterpret_cast<uint32_t*>(get_header(page)->reserved));
+            for (uint16_t i = 0; i < get_header(page)->cell_count; i++) {
+                uint16_t len;
+                internal_key(page, i, len);
+                longest = std::max<size_t>(longest, len);
+                below.push_back(reinterpret_cast<InternalEntry*>(page.data + *slot_ptr(page, i))->child_page);
+            }
+        }
+        level = below;
+        height++;
+    }
+}
+
+void test_btree_suffix_truncation() {
+    std::cout << "\n=== B+ Tree Separator Suffix Truncation Test ===\n";
+
+    const std::string table = "test_btree_suffix";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+    TableHandle th(table);
+    assert(open_table(table, th) && "open_table failed");
+
+    // keys that differ early and carry a long distinct tail, like paths or urls
+    const int num_keys = 30000;
+    auto long_key = [](int n) {
+        std::string k = "doc/" + scan_key(n) + "/";
+        while (k.size() < 300) {
+            k += std::to_string(n * 7919 + k.size());
+        }
+        return k;
+    };
+    std::vector<int> order(num_keys);
+    for (int i = 0; i < num_keys; i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(23));
+    for (int n : order) {
+        std::string k = long_key(n);
+        assert(btree_insert(th, {(const uint8_t*)k.c_str(), (uint16_t)k.size()}, {(const uint8_t*)"v", 1}) &&
+               "Insert failed");
+    }
+
+    // a separator needs the bytes up to the first one that tells two neighbours apart
+    int height;
+    size_t longest = longest_separator(th, height);
+    std::cout << "[OK] Height " << height << ", longest separator " << longest << " bytes of "
+              << long_key(0).size() << " byte keys\n";
+    assert(longest < 20 && "Separators should be cut to the distinguishing prefix");
+    assert(height <= 3 && "Short separators should keep the tree shallow");
+
+    for (int n = 0; n < num_keys; n++) {
+        std::string k = long_key(n);
+        Value value;
+        assert(btree_search(th, {(const uint8_t*)k.c_str(), (uint16_t)k.size()}, value) && "Key lost");
+    }
+    // deleting rebalances leaves, their new separators are cut too
+    for (int n = 0; n < num_keys; n += 3) {
+        std::string k = long_key(n);
+        assert(btree_delete(th, {(const uint8_t*)k.c_str(), (uint16_t)k.size()}) && "Delete failed");
+    }
+    assert(longest_separator(th, height) < 20);
+    int count = 0;
+    BTreeCursor cursor(th);
+    for (bool ok = cursor.seek_first(); ok; ok = cursor.next()) {
+        count++;
+    }
+    for (int n = 0; n < num_keys; n++) {
+        std::string k = long_key(n);
+        Value value;
+        assert(btree_search(th, {(const uint8_t*)k.c_str(), (uint16_t)k.size()}, value) == (n % 3 != 0));
+    }
+    assert(count == num_keys - (num_keys + 2) / 3);
+    std::cout << "[OK] " << count << " keys left after deletes\n";
+
+    // the bulk loader promotes the same short separators
+    const std::string bulk_table = "test_btree_suffix_bulk";
+    remove(("data/" + bulk_table + ".db").c_str());
+    assert(create_table(bulk_table));
+    TableHandle bulk(bulk_table);
+    assert(open_table(bulk_table, bulk));
+    int next = 0;
+    std::string k;
+    assert(btree_bulk_load(bulk, [&](Key& key, Value& value) {
+        if (next == num_keys) {
+            return false;
+        }
+        k = long_key(next++);
+        key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+        value = {(const uint8_t*)"v", 1};
+        return true;
+    }) && "Bulk load failed");
+    assert(longest_separator(bulk, height) < 20);
+    for (int n = 0; n < num_keys; n += 7) {
+        std::string key_str = long_key(n);
+        Value value;
+        assert(btree_search(bulk, {(const uint8_t*)key_str.c_str(), (uint16_t)key_str.size()}, value));
+    }
+    std::cout << "[OK] Bulk load: height " << height << "\n";
+
+    std::cout << "\n=== Separator Suffix Truncation Test PASSED ===\n";
+}
+
 void test_btree_large_value_split();
 void hexdump_database(const std::string& table_name) {
     std::cout << "\n=== Database Hexdump for table: " << table_name << " ===\n";
@@ -366,8 +1445,11 @@ void hexdump_database(const std::string& table_name) {
         if (ph->page_level == PageLevel::LEAF) {
             std::cout << indent << "\n--- Leaf Page Entries ---\n";
             for (uint16_t i = 0; i < ph->cell_count; i++) {
-                uint16_t key_len, value_len;
-                const uint8_t* key_data = slot_key(page, i, key_len);
+                std::vector<uint8_t> key;
+                slot_key(page, i, key);
+                const uint8_t* key_data = key.data();
+                uint16_t key_len = static_cast<uint16_t>(key.size());
+                uint16_t value_len;
                 const uint8_t* value_data = slot_value(page, i, value_len);
                 
                 if (key_data == nullptr || key_len == 0) {
@@ -571,7 +1653,8 @@ void test_btree_large_value_split() {
             std::cerr << static_cast<char>(k1.data[j]);
         }
         std::cerr << "'\n";
-        // Dump database for debugging
+        // Dump database for debugging (write back cached pages first)
+        th.bpm.flush_all_pages();
         std::cout << "\n[DEBUG] Dumping database structure for debugging...\n";
         hexdump_database("test_btree_large_split");
     }
@@ -598,13 +1681,11 @@ void test_btree_large_value_split() {
     std::cout << "[OK] All small values still accessible and correct after split\n";
     
     // Verify the tree structure by checking root page
-    Page meta_page;
-    th.dm.read_page(0, meta_page.data);
-    PageHeader* meta_ph = get_header(meta_page);
+    PageGuard meta_page = th.bpm.fetch_page_guard(0);
+    PageHeader* meta_ph = get_header(meta_page.page());
     
-    Page root_page;
-    th.dm.read_page(meta_ph->root_page, root_page.data);
-    PageHeader* root_ph = get_header(root_page);
+    PageGuard root_page = th.bpm.fetch_page_guard(meta_ph->root_page);
+    PageHeader* root_ph = get_header(root_page.page());
     
     // After split, if we have an internal node, it means the root split
     // If we still have a leaf, the split happened but root didn't split yet
@@ -624,6 +1705,18 @@ int main() {
         test_btree_many_inserts();
         test_btree_empty_tree();
         test_btree_email_keys();
+        test_btree_mmap_read_only();
+        test_btree_cursor_scan();
+        test_btree_reverse_scan();
+        test_btree_delete();
+        test_btree_compaction();
+        test_btree_bulk_load();
+        test_btree_insert_batch();
+        test_btree_multi_get();
+        test_btree_internal_split();
+        test_btree_overflow_values();
+        test_btree_prefix_compression();
+        test_btree_suffix_truncation();
         
         test_btree_large_value_split();
         
@@ -0,0 +1,321 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include "storage/buffer_pool.hpp"
+#include "storage/disk_manager.hpp"
+#include "storage/btree.hpp"
+#include "storage/table_handle.hpp"
+#include "storage/page.hpp"
+#include "common/constants.hpp"
+
+void test_lru_replacer() {
+    std::cout << "\n=== LRU Replacer Test ===\n";
+
+    LRUReplacer replacer(4);
+    replacer.unpin(0);
+    replacer.unpin(1);
+    replacer.unpin(2);
+    assert(replacer.size() == 3);
+
+    // 1 is in use again, so 0 then 2 go first
+    replacer.pin(1);
+    frame_id_t victim;
+    assert(replacer.victim(victim) && victim == 0);
+    assert(replacer.victim(victim) && victim == 2);
+    assert(!replacer.victim(victim) && "Nothing should be evictable");
+    std::cout << "[OK] Least recently unpinned frame is evicted first\n";
+
+    std::cout << "\n=== LRU Replacer Test PASSED ===\n";
+}
+
+void test_clock_replacer() {
+    std::cout << "\n=== Clock Replacer Test ===\n";
+
+    ClockReplacer replacer(3);
+    replacer.unpin(0);
+    replacer.unpin(1);
+    replacer.unpin(2);
+    assert(replacer.size() == 3);
+
+    frame_id_t victim;
+    assert(replacer.victim(victim) && victim == 0);
+
+    // 1 gets a second chance after being touched again
+    replacer.pin(1);
+    replacer.unpin(1);
+    assert(replacer.victim(victim) && victim == 2);
+    assert(replacer.victim(victim) && victim == 1);
+    assert(replacer.size() == 0);
+    std::cout << "[OK] Clock sweeps evictable frames and honours reference bits\n";
+
+    std::cout << "\n=== Clock Replacer Test PASSED ===\n";
+}
+
+void test_fetch_evict_and_write_back() {
+    std::cout << "\n=== Buffer Pool Fetch / Evict Test ===\n";
+
+    const std::string table = "test_buffer_pool";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+
+    DiskManager dm(path);
+    {
+        BufferPoolManager bpm(3, &dm);
+
+        // stamp five pages, only three fit so the first ones must be written back on eviction
+        for (uint32_t pid = 0; pid < 5; pid++) {
+            Page* page = bpm.new_page(pid);
+            init_page(*page, pid, PageType::DATA, PageLevel::LEAF);
+            page->data[sizeof(PageHeader)] = static_cast<uint8_t>('a' + pid);
+            assert(bpm.unpin_page(pid, true));
+        }
+        std::cout << "[OK] Wrote 5 pages through a 3 frame pool\n";
+
+        for (uint32_t pid = 0; pid < 5; pid++) {
+            Page* page = bpm.fetch_page(pid);
+            assert(get_header(*page)->page_id == pid && "Page id mismatch after eviction");
+            assert(page->data[sizeof(PageHeader)] == 'a' + pid && "Dirty page lost on eviction");
+            bpm.unpin_page(pid, false);
+        }
+        std::cout << "[OK] Evicted dirty pages were written back and re-read\n";
+
+        // repeated access to a cached page never touches the disk
+        uint64_t misses = bpm.misses();
+        for (int i = 0; i < 10; i++) {
+            PageGuard guard = bpm.fetch_page_guard(4);
+        }
+        assert(bpm.misses() == misses && "Cached page should be a hit");
+        std::cout << "[OK] Cached page served from memory\n";
+
+        // pinned pages are never evicted, a full pool throws instead
+        PageGuard g0 = bpm.fetch_page_guard(0);
+        PageGuard g1 = bpm.fetch_page_guard(1);
+        PageGuard g2 = bpm.fetch_page_guard(2);
+        bool threw = false;
+        try {
+            bpm.fetch_page(3);
+        }
+        catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw && "Fetching into a fully pinned pool should fail");
+        std::cout << "[OK] Fully pinned pool refuses to evict\n";
+    }
+
+    // destructor flushed everything, a fresh pool sees the data
+    BufferPoolManager bpm(2, &dm, std::make_unique<ClockReplacer>(2));
+    for (uint32_t pid = 0; pid < 5; pid++) {
+        PageGuard guard = bpm.fetch_page_guard(pid);
+        assert(guard.page().data[sizeof(PageHeader)] == 'a' + pid);
+    }
+    std::cout << "[OK] Pages persisted after pool teardown\n";
+
+    std::cout << "\n=== Buffer Pool Fetch / Evict Test PASSED ===\n";
+}
+
+void test_btree_uses_pool() {
+    std::cout << "\n=== B+ Tree Through Buffer Pool Test ===\n";
+
+    const std::string table = "test_buffer_pool_btree";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+
+    assert(create_table(table) && "create_table failed");
+    {
+        TableHandle th(table);
+        assert(open_table(table, th) && "open_table failed");
+
+        const int num_keys = 2000;
+        for (int i = 0; i < num_keys; i++) {
+            std::string k = "key" + std::to_string(i);
+            std::string v = "val" + std::to_string(i);
+            Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+            Value value = {(const uint8_t*)v.c_str(), (uint16_t)v.size()};
+            assert(btree_insert(th, key, value) && "btree_insert failed");
+        }
+        std::cout << "[OK] Inserted " << num_keys << " keys (tree has split)\n";
+
+        uint64_t misses = th.bpm.misses();
+        for (int i = 0; i < num_keys; i++) {
+            std::string k = "key" + std::to_string(i);
+            std::string v = "val" + std::to_string(i);
+            Key key = {(const uint8_t*)k.c_str(), (uint16_t)k.size()};
+            Value result;
+            assert(btree_search(th, key, result) && "btree_search failed");
+            assert(result.size == v.size() && memcmp(result.data, v.c_str(), v.size()) == 0);
+        }
+        // every page of this tree fits in the pool, so lookups never miss
+        assert(th.bpm.misses() == misses && "Lookups should be served from the pool");
+        std::cout << "[OK] " << num_keys << " lookups without a single disk read\n";
+    }
+
+    // reopening reads the pages the pool wrote back
+    TableHandle th(table);
+    assert(open_table(table, th) && "reopen failed");
+    Key key = {(const uint8_t*)"key1234", 7};
+    Value result;
+    assert(btree_search(th, key, result) && "Key lost after reopen");
+    assert(result.size == 7 && memcmp(result.data, "val1234", 7) == 0);
+    std::cout << "[OK] Tree intact after pool write-back and reopen\n";
+
+    std::cout << "\n=== B+ Tree Through Buffer Pool Test PASSED ===\n";
+}
+
+void test_discard_page() {
+    std::cout << "\n=== Buffer Pool Discard Test ===\n";
+
+    const std::string table = "test_buffer_pool_discard";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+
+    DiskManager dm(path);
+    BufferPoolManager bpm(2, &dm);
+
+    // page 3 is written to disk behind the pool's back while a stale dirty copy is cached
+    {
+        PageGuard guard = bpm.new_page_guard(3);
+        init_page(guard.page(), 3, PageType::DATA, PageLevel::LEAF);
+        guard.page().data[sizeof(PageHeader)] = 'x';
+        guard.mark_dirty();
+        assert(!bpm.discard_page(3) && "A pinned page must not be discarded");
+    }
+    Page direct;
+    init_page(direct, 3, PageType::DATA, PageLevel::LEAF);
+    direct.data[sizeof(PageHeader)] = 'y';
+    dm.write_page(3, direct.data);
+
+    assert(bpm.discard_page(3));
+    assert(bpm.discard_page(7) && "Uncached pages are trivially discarded");
+    bpm.flush_all_pages();
+    PageGuard guard = bpm.fetch_page_guard(3);
+    assert(guard.page().data[sizeof(PageHeader)] == 'y' && "Discarded copy was written back");
+    std::cout << "[OK] Discarded page is re-read, not written back\n";
+
+    std::cout << "\n=== Buffer Pool Discard Test PASSED ===\n";
+}
+
+void test_pinned_page_protection() {
+    std::cout << "\n=== Buffer Pool Pinned Page Test ===\n";
+
+    const std::string table = "test_buffer_pool_pinned";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+
+    DiskManager dm(path);
+    BufferPoolManager bpm(4, &dm);
+
+    PageGuard held = bpm.new_page_guard(3);
+    init_page(held.page(), 3, PageType::DATA, PageLevel::LEAF);
+    held.page().data[sizeof(PageHeader)] = 'x';
+    held.mark_dirty();
+
+    // reusing the id of a page someone holds must not zero it under them
+    bool threw = false;
+    try {
+        bpm.new_page(3);
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw && "new_page on a pinned page should throw");
+    assert(held.page().data[sizeof(PageHeader)] == 'x' && "Pinned page was wiped");
+    std::cout << "[OK] new_page refuses a pinned page\n";
+
+    // a refused reset changes nothing: the unpinned page stays cached and dirty
+    {
+        PageGuard other = bpm.new_page_guard(4);
+        init_page(other.page(), 4, PageType::DATA, PageLevel::LEAF);
+        other.page().data[sizeof(PageHeader)] = 'y';
+        other.mark_dirty();
+    }
+    threw = false;
+    try {
+        bpm.reset();
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw && "reset with a pinned page should throw");
+    uint64_t hits = bpm.hits();
+    {
+        PageGuard other = bpm.fetch_page_guard(4);
+        assert(bpm.hits() == hits + 1 && other.page().data[sizeof(PageHeader)] == 'y' &&
+               "Refused reset dropped a cached page");
+    }
+    Page on_disk;
+    dm.read_page(4, on_disk.data);
+    assert(on_disk.data[sizeof(PageHeader)] != 'y' && "Refused reset should not have flushed");
+
+    held = PageGuard();
+    bpm.reset();
+    dm.read_page(4, on_disk.data);
+    assert(on_disk.data[sizeof(PageHeader)] == 'y' && "reset writes back dirty pages");
+    std::cout << "[OK] reset checks every pin before flushing\n";
+
+    std::cout << "\n=== Buffer Pool Pinned Page Test PASSED ===\n";
+}
+
+void test_failed_write_back_keeps_frame() {
+    std::cout << "\n=== Buffer Pool Failed Write-back Test ===\n";
+
+    const std::string table = "test_buffer_pool_write_back";
+    std::string path = "data/" + table + ".db";
+    remove(path.c_str());
+    assert(create_table(table) && "create_table failed");
+
+    // a read-only disk manager refuses every write, so evicting a dirty page fails
+    DiskManagerOptions options;
+    options.read_only = true;
+    DiskManager dm(path, options);
+    BufferPoolManager bpm(1, &dm);
+    {
+        PageGuard guard = bpm.new_page_guard(1);
+        init_page(guard.page(), 1, PageType::DATA, PageLevel::LEAF);
+        guard.mark_dirty();
+    }
+
+    // the victim must stay evictable after the failed write, not vanish from the pool
+    for (int attempt = 0; attempt < 2; attempt++) {
+        std::string error;
+        try {
+            bpm.fetch_page_guard(2);
+        }
+        catch (const std::runtime_error& e) {
+            error = e.what();
+        }
+        assert(!error.empty() && "Evicting a dirty page on a read-only file should throw");
+        assert(error.find("exhausted") == std::string::npos && "Failed write-back lost the frame");
+    }
+    assert(bpm.discard_page(1));
+    PageGuard other = bpm.fetch_page_guard(2);
+    assert(other.valid());
+    std::cout << "[OK] A failed write-back leaves the victim cached and evictable\n";
+
+    std::cout << "\n=== Buffer Pool Failed Write-back Test PASSED ===\n";
+}
+
+int main() {
+    try {
+        test_lru_replacer();
+        test_clock_replacer();
+        test_fetch_evict_and_write_back();
+        test_btree_uses_pool();
+        test_discard_page();
+        test_pinned_page_protection();
+        test_failed_write_back_keeps_frame();
+
+        std::cout << "\n\n=== ALL BUFFER POOL TESTS PASSED ===\n";
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}